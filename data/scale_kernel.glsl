@@ -0,0 +1,45 @@
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+varying vec2 vTexcoord;
+uniform sampler2D s_tex;
+uniform sampler2D s_weights;
+
+/* (1, 0) for the horizontal pass, (0, 1) for the vertical one */
+uniform vec2 axis;
+/* texels of s_tex along the axis */
+uniform float source_size;
+/* centres of the first and the last texel the taps may read, so the
+ * kernel does not pick up texels outside of the crop */
+uniform vec2 limits;
+
+/* the sink defines TAPS, the texels the kernel reads along the axis */
+
+/* weights are stored as (w + 1) / 2 in 16 bits, split into a low byte in
+ * luminance and a high byte in alpha */
+float weight(float phase, int tap)
+{
+    vec2 pair = texture2D(s_weights,
+            vec2(phase, (float(tap) + 0.5) / float(TAPS))).ra;
+    return (pair.x * 255.0 + pair.y * 65280.0) / 65535.0 * 2.0 - 1.0;
+}
+
+void main()
+{
+    float along = dot(vTexcoord, axis);
+    float pos = along * source_size - 0.5;
+    float base = floor(pos);
+    float phase = pos - base;
+    vec3 sum = vec3(0.0);
+
+    for (int i = 0; i < TAPS; i++) {
+        float texel = clamp(base + float(i - TAPS / 2 + 1) + 0.5,
+                            limits.x, limits.y);
+        vec2 coord = vTexcoord + axis * (texel / source_size - along);
+        sum += texture2D(s_tex, coord).rgb * weight(phase, i);
+    }
+
+    gl_FragColor = vec4(clamp(sum, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,133 @@
+/* shared by the yuv conversion shaders, which the sink compiles with
+ * this file in front of their own source */
+#if defined(GL_FRAGMENT_PRECISION_HIGH) && (defined(YUV_16BIT) || defined(TONE_MAP) || defined(YUV_PACKED))
+precision highp float;
+#else
+precision mediump float;
+#endif
+varying vec2 vTexcoord;
+uniform sampler2D s_ytex;
+uniform sampler2D s_utex;
+uniform sampler2D s_vtex;
+
+/* the sink defines YUV_16BIT for 16 bit samples, YUV_BYTE_PAIRS if they
+ * are split into a low and a high byte, YUV_SEMIPLANAR if u and v are
+ * interleaved in s_utex and YUV_SCALE to bring them to 0..1. YUV_PACKED
+ * puts all planes of a PACKED_HEIGHT rows high frame into s_ytex: the
+ * luma rows, then u and v with two chroma rows side by side per row */
+#if defined(YUV_PACKED)
+float sample_y(vec2 coord)
+{
+   /* the deinterlacer must not read past the last luma row */
+   float y = min(coord.y, 1.0 - 0.5 / PACKED_HEIGHT);
+   return texture2D(s_ytex, vec2(coord.x, y * (2.0 / 3.0))).r;
+}
+
+/* where the chroma of coord is in the plane from texture row first */
+vec2 packed_chroma(vec2 coord, float first)
+{
+   float row = clamp(floor(coord.y * PACKED_HEIGHT * 0.5), 0.0,
+                     PACKED_HEIGHT * 0.5 - 1.0);
+   return vec2((coord.x + mod(row, 2.0)) * 0.5,
+               (first + floor(row * 0.5) + 0.5) / (PACKED_HEIGHT * 1.5));
+}
+
+vec2 sample_uv(vec2 coord)
+{
+   return vec2(texture2D(s_ytex, packed_chroma(coord, PACKED_HEIGHT)).r,
+               texture2D(s_ytex,
+                         packed_chroma(coord, PACKED_HEIGHT * 1.25)).r);
+}
+#elif defined(YUV_BYTE_PAIRS)
+float unpack(vec2 bytes)
+{
+   return dot(bytes, vec2(255.0, 65280.0)) / 65535.0 * YUV_SCALE;
+}
+
+float sample_y(vec2 coord)
+{
+   return unpack(texture2D(s_ytex, coord).ra);
+}
+
+#ifdef YUV_SEMIPLANAR
+vec2 sample_uv(vec2 coord)
+{
+   vec4 uv = texture2D(s_utex, coord);
+   return vec2(unpack(uv.rg), unpack(uv.ba));
+}
+#else
+vec2 sample_uv(vec2 coord)
+{
+   return vec2(unpack(texture2D(s_utex, coord).ra),
+               unpack(texture2D(s_vtex, coord).ra));
+}
+#endif
+#else
+#ifndef YUV_SCALE
+#define YUV_SCALE 1.0
+#endif
+
+float sample_y(vec2 coord)
+{
+   return texture2D(s_ytex, coord).r * YUV_SCALE;
+}
+
+#ifdef YUV_SEMIPLANAR
+vec2 sample_uv(vec2 coord)
+{
+   return texture2D(s_utex, coord).rg * YUV_SCALE;
+}
+#else
+vec2 sample_uv(vec2 coord)
+{
+   return vec2(texture2D(s_utex, coord).r,
+               texture2D(s_vtex, coord).r) * YUV_SCALE;
+}
+#endif
+#endif
+
+#ifdef TONE_MAP
+uniform sampler2D s_lut;
+
+/* the lut maps a PQ or HLG coded value to tone mapped linear light, as
+ * 16 bit values split into a low and a high byte */
+float tone_map(float c)
+{
+   float x = (clamp(c, 0.0, 1.0) * 1023.0 + 0.5) / 1024.0;
+   vec2 bytes = texture2D(s_lut, vec2(x, 0.5)).ra;
+   return dot(bytes, vec2(255.0, 65280.0)) / 65535.0;
+}
+#endif
+
+/* YUV_BT2020 selects the BT.2020 instead of the BT.601 matrix. TONE_MAP
+ * maps PQ or HLG to SDR through the lut and GAMUT_BT2020 converts the
+ * result from BT.2020 to BT.709 primaries, both in linear light */
+vec3 yuv_to_rgb(float y, vec2 uv)
+{
+   float u = uv.x - 0.5;
+   float v = uv.y - 0.5;
+   vec3 rgb;
+
+   y = 1.1643 * (y - 0.0625);
+#ifdef YUV_BT2020
+   rgb.r = y + 1.6787 * v;
+   rgb.g = y - 0.18733 * u - 0.65042 * v;
+   rgb.b = y + 2.1418 * u;
+#else
+   rgb.r = y + 1.5958 * v;
+   rgb.g = y - 0.39173 * u - 0.81290 * v;
+   rgb.b = y + 2.017 * u;
+#endif
+
+#ifdef TONE_MAP
+   rgb = vec3(tone_map(rgb.r), tone_map(rgb.g), tone_map(rgb.b));
+#ifdef GAMUT_BT2020
+   rgb = mat3(1.6605, -0.1246, -0.0182,
+              -0.5876, 1.1329, -0.1006,
+              -0.0728, -0.0083, 1.1187) * rgb;
+#endif
+   rgb = pow(max(rgb, 0.0), vec3(1.0 / 2.2));
+#endif
+
+   return rgb;
+}
@@ -0,0 +1,5 @@
+void main()
+{
+   gl_FragColor = vec4(yuv_to_rgb(sample_y(vTexcoord),
+                                  sample_uv(vTexcoord)), 1.0);
+}
@@ -0,0 +1,653 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Throughput benchmark for glessink.
+ *
+ * Pushes one synthetic frame over and over into glessink, with sync
+ * disabled, for every combination of resolution, format, deinterlace
+ * mode, window size and number of instances. Prints one JSON object
+ * per combination: the frames per second, the mean cpu (and gpu, where
+ * timer queries exist) time of each render stage and the process cpu
+ * time per frame.
+ *
+ * With several instances, that many pipelines run at the same time in
+ * this process, each into its own glessink sharing one display. fps is
+ * then the sum over all of them, min-fps the slowest one, jitter the
+ * mean standard deviation of the frame interval of an instance and
+ * lock-wait the mean time a frame waited for the display lock. That
+ * shows where adding instances stops adding throughput.
+ *
+ * It runs headless with the pbuffer or surfaceless backend, e.g. on
+ * Mesa's llvmpipe:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 GST_PLUGIN_PATH=src/.libs \
+ *       src/glesbench --backend=surfaceless --resolutions=720p,1080p
+ *
+ * or, for the scaling of a video wall on X11:
+ *
+ *   src/glesbench --backend=x11 --resolutions=sd --windows=480x270 \
+ *       --instances=1,4,16,32
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+#include <gst/video/video.h>
+
+/* Source */
+
+/* pushes copies of one prepared frame, so the benchmark measures the
+ * sink and not the generation of test patterns */
+typedef struct _GstGLESBenchSrc      GstGLESBenchSrc;
+typedef struct _GstGLESBenchSrcClass GstGLESBenchSrcClass;
+
+struct _GstGLESBenchSrc
+{
+    GstPushSrc element;
+
+    GstVideoInfo info;
+    GstBuffer *frame;
+    guint64 count;
+    guint64 pushed;
+};
+
+struct _GstGLESBenchSrcClass
+{
+    GstPushSrcClass parent_class;
+};
+
+static GType gst_gles_bench_src_get_type (void);
+G_DEFINE_TYPE (GstGLESBenchSrc, gst_gles_bench_src, GST_TYPE_PUSH_SRC);
+
+static GstStaticPadTemplate bench_src_factory =
+    GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw")
+    );
+
+static GstCaps *
+gst_gles_bench_src_get_caps (GstBaseSrc *basesrc, GstCaps *filter)
+{
+    GstGLESBenchSrc *src = (GstGLESBenchSrc *) basesrc;
+    GstCaps *caps = gst_video_info_to_caps (&src->info);
+
+    if (filter) {
+        GstCaps *tmp = gst_caps_intersect (filter, caps);
+        gst_caps_unref (caps);
+        caps = tmp;
+    }
+
+    return caps;
+}
+
+static GstFlowReturn
+gst_gles_bench_src_create (GstPushSrc *pushsrc, GstBuffer **outbuf)
+{
+    GstGLESBenchSrc *src = (GstGLESBenchSrc *) pushsrc;
+    GstClockTime duration = gst_util_uint64_scale_int (GST_SECOND,
+            GST_VIDEO_INFO_FPS_D (&src->info),
+            GST_VIDEO_INFO_FPS_N (&src->info));
+
+    if (src->pushed >= src->count)
+        return GST_FLOW_EOS;
+
+    /* shares the memory, only the metadata is new */
+    *outbuf = gst_buffer_copy (src->frame);
+    GST_BUFFER_PTS (*outbuf) = src->pushed * duration;
+    GST_BUFFER_DURATION (*outbuf) = duration;
+    src->pushed++;
+
+    return GST_FLOW_OK;
+}
+
+static void
+gst_gles_bench_src_finalize (GObject *object)
+{
+    GstGLESBenchSrc *src = (GstGLESBenchSrc *) object;
+
+    if (src->frame)
+        gst_buffer_unref (src->frame);
+
+    G_OBJECT_CLASS (gst_gles_bench_src_parent_class)->finalize (object);
+}
+
+static void
+gst_gles_bench_src_class_init (GstGLESBenchSrcClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+    GstBaseSrcClass *basesrc_class = GST_BASE_SRC_CLASS (klass);
+    GstPushSrcClass *pushsrc_class = GST_PUSH_SRC_CLASS (klass);
+
+    gobject_class->finalize = gst_gles_bench_src_finalize;
+    basesrc_class->get_caps = gst_gles_bench_src_get_caps;
+    pushsrc_class->create = gst_gles_bench_src_create;
+
+    gst_element_class_set_details_simple (element_class,
+        "GLES benchmark source", "Source/Video",
+        "Repeats one synthetic frame", "Julian Scheel <julian jusst de>");
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&bench_src_factory));
+}
+
+static void
+gst_gles_bench_src_init (GstGLESBenchSrc *src)
+{
+    gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
+/* fills every plane with a gradient, so no stage sees a flat frame */
+static GstBuffer *
+bench_make_frame (GstVideoInfo *info)
+{
+    GstBuffer *buf = gst_buffer_new_allocate (NULL,
+                                              GST_VIDEO_INFO_SIZE (info),
+                                              NULL);
+    GstVideoFrame frame;
+    guint i;
+    gint x, y;
+
+    gst_video_frame_map (&frame, info, buf, GST_MAP_WRITE);
+    for (i = 0; i < GST_VIDEO_FRAME_N_PLANES (&frame); i++) {
+        guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (&frame, i);
+        gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, i);
+        gint width = GST_VIDEO_FRAME_COMP_WIDTH (&frame, i) *
+                GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, i);
+        gint height = GST_VIDEO_FRAME_COMP_HEIGHT (&frame, i);
+
+        for (y = 0; y < height; y++)
+            for (x = 0; x < width; x++)
+                data[y * stride + x] = (x + y + i * 64) & 0xff;
+    }
+    gst_video_frame_unmap (&frame);
+
+    return buf;
+}
+
+/* Measurement */
+
+/* measurements of one pipeline */
+typedef struct
+{
+    guint warmup;
+    guint64 frames;
+
+    GstClockTime first;
+    GstClockTime last;
+    GstClockTime cpu_first;
+    GstClockTime cpu_last;
+
+    /* frame intervals, for the jitter */
+    GstClockTime previous;
+    gdouble interval_sum;
+    gdouble interval_sq_sum;
+
+    /* stage name to summed time, over the measured frames */
+    GstStructure *sums;
+    guint64 measured;
+} BenchRun;
+
+static GstClockTime
+bench_cpu_time (void)
+{
+    struct rusage usage;
+
+    getrusage (RUSAGE_SELF, &usage);
+
+    return GST_TIMEVAL_TO_TIME (usage.ru_utime) +
+           GST_TIMEVAL_TO_TIME (usage.ru_stime);
+}
+
+static gboolean
+bench_add_stage (GQuark field_id, const GValue *value, gpointer user_data)
+{
+    GstStructure *sums = user_data;
+    const gchar *name = g_quark_to_string (field_id);
+    guint64 sum = 0;
+
+    if (!G_VALUE_HOLDS_UINT64 (value) ||
+        (!g_str_has_suffix (name, "-cpu") &&
+         !g_str_has_suffix (name, "-gpu") &&
+         !g_str_equal (name, "lock-wait")))
+        return TRUE;
+
+    /* stages not timed on the gpu stay invalid */
+    if (!GST_CLOCK_TIME_IS_VALID (g_value_get_uint64 (value)))
+        return TRUE;
+
+    gst_structure_get_uint64 (sums, name, &sum);
+    gst_structure_set (sums, name, G_TYPE_UINT64,
+                       sum + g_value_get_uint64 (value), NULL);
+
+    return TRUE;
+}
+
+/* runs on the gl thread of the sink, right after each frame */
+static GstBusSyncReply
+bench_sync_handler (GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    BenchRun *run = user_data;
+    const GstStructure *s;
+    GstClockTime now;
+
+    if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_ELEMENT)
+        return GST_BUS_PASS;
+
+    s = gst_message_get_structure (message);
+    if (!gst_structure_has_name (s, "GstGLESSinkTimings"))
+        return GST_BUS_PASS;
+
+    now = gst_util_get_timestamp ();
+    run->frames++;
+    if (run->frames == run->warmup) {
+        run->first = now;
+        run->cpu_first = bench_cpu_time ();
+    } else if (run->frames > run->warmup) {
+        gdouble interval = now - run->previous;
+
+        run->last = now;
+        run->cpu_last = bench_cpu_time ();
+        run->measured++;
+        run->interval_sum += interval;
+        run->interval_sq_sum += interval * interval;
+        gst_structure_foreach (s, bench_add_stage, run->sums);
+    }
+    run->previous = now;
+
+    gst_message_unref (message);
+    return GST_BUS_DROP;
+}
+
+static gdouble
+bench_run_fps (BenchRun *run)
+{
+    if (run->last <= run->first)
+        return 0.0;
+
+    return (gdouble) run->measured * GST_SECOND / (run->last - run->first);
+}
+
+/* standard deviation of the frame interval */
+static GstClockTime
+bench_run_jitter (BenchRun *run)
+{
+    gdouble mean;
+    gdouble variance;
+
+    if (run->measured < 2)
+        return 0;
+
+    mean = run->interval_sum / run->measured;
+    variance = run->interval_sq_sum / run->measured - mean * mean;
+
+    return variance > 0.0 ? (GstClockTime) sqrt (variance) : 0;
+}
+
+typedef struct
+{
+    GString *json;
+    guint64 frames;
+} BenchPrint;
+
+static gboolean
+bench_print_stage (GQuark field_id, const GValue *value, gpointer user_data)
+{
+    BenchPrint *print = user_data;
+    GString *json = print->json;
+
+    g_string_append_printf (json, "%s\"%s\": %" G_GUINT64_FORMAT,
+                            json->str[json->len - 1] == '{' ? "" : ", ",
+                            g_quark_to_string (field_id),
+                            g_value_get_uint64 (value) / print->frames);
+
+    return TRUE;
+}
+
+/* Matrix */
+
+typedef struct
+{
+    const gchar *backend;
+    gint width;
+    gint height;
+    const gchar *format;
+    gboolean deinterlace;
+    gint window_width;
+    gint window_height;
+    gint instances;
+} BenchCase;
+
+static gint opt_frames = 300;
+static gint opt_warmup = 30;
+static gchar *opt_backend = NULL;
+static gchar *opt_resolutions = NULL;
+static gchar *opt_formats = NULL;
+static gchar *opt_deinterlace = NULL;
+static gchar *opt_windows = NULL;
+static gchar *opt_instances = NULL;
+
+static GOptionEntry bench_options[] = {
+    { "frames", 'n', 0, G_OPTION_ARG_INT, &opt_frames,
+      "Frames measured per case (default 300)", "N" },
+    { "warmup", 'w', 0, G_OPTION_ARG_INT, &opt_warmup,
+      "Frames rendered before measuring (default 30)", "N" },
+    { "backend", 'b', 0, G_OPTION_ARG_STRING, &opt_backend,
+      "glessink backend: x11, pbuffer or surfaceless (default pbuffer)",
+      "NAME" },
+    { "resolutions", 'r', 0, G_OPTION_ARG_STRING, &opt_resolutions,
+      "Video sizes, sd, 720p, 1080p, 4k, 8k or WxH (default sd to 4k)",
+      "LIST" },
+    { "formats", 'f', 0, G_OPTION_ARG_STRING, &opt_formats,
+      "Video formats (default I420)", "LIST" },
+    { "deinterlace", 'd', 0, G_OPTION_ARG_STRING, &opt_deinterlace,
+      "Deinterlace modes, on and/or off (default on,off)", "LIST" },
+    { "windows", 'W', 0, G_OPTION_ARG_STRING, &opt_windows,
+      "Window sizes as WxH (default 720x576,1920x1080)", "LIST" },
+    { "instances", 'i', 0, G_OPTION_ARG_STRING, &opt_instances,
+      "Numbers of pipelines run at the same time, each into its own "
+      "glessink (default 1)", "LIST" },
+    { NULL }
+};
+
+static gboolean
+bench_parse_size (const gchar *name, gint *width, gint *height)
+{
+    static const struct {
+        const gchar *name;
+        gint width;
+        gint height;
+    } sizes[] = {
+        { "sd", 720, 576 },
+        { "720p", 1280, 720 },
+        { "1080p", 1920, 1080 },
+        { "4k", 3840, 2160 },
+        { "8k", 7680, 4320 }
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+        if (g_ascii_strcasecmp (name, sizes[i].name) == 0) {
+            *width = sizes[i].width;
+            *height = sizes[i].height;
+            return TRUE;
+        }
+    }
+
+    return sscanf (name, "%dx%d", width, height) == 2 &&
+           *width > 0 && *height > 0;
+}
+
+static GstElement *
+bench_pipeline_new (const BenchCase *c, BenchRun *run)
+{
+    GstGLESBenchSrc *src;
+    GstElement *pipeline;
+    GstElement *sink;
+    GstBus *bus;
+
+    sink = gst_element_factory_make ("glessink", NULL);
+    if (!sink) {
+        g_printerr ("glessink not found, set GST_PLUGIN_PATH to the "
+                    "directory of the plugin\n");
+        return NULL;
+    }
+    gst_util_set_object_arg (G_OBJECT (sink), "backend", c->backend);
+    g_object_set (sink, "sync", FALSE, "report_timings", TRUE,
+                  "deinterlace", c->deinterlace,
+                  "window_width", c->window_width,
+                  "window_height", c->window_height, NULL);
+
+    src = g_object_new (gst_gles_bench_src_get_type (), NULL);
+    gst_video_info_set_format (&src->info,
+                               gst_video_format_from_string (c->format),
+                               c->width, c->height);
+    GST_VIDEO_INFO_FPS_N (&src->info) = 60;
+    GST_VIDEO_INFO_FPS_D (&src->info) = 1;
+    src->frame = bench_make_frame (&src->info);
+    src->count = opt_warmup + opt_frames;
+
+    pipeline = gst_pipeline_new (NULL);
+    gst_bin_add_many (GST_BIN (pipeline), GST_ELEMENT (src), sink, NULL);
+    gst_element_link (GST_ELEMENT (src), sink);
+
+    run->warmup = MAX (opt_warmup, 1);
+    run->sums = gst_structure_new_empty ("stages");
+    bus = gst_element_get_bus (pipeline);
+    gst_bus_set_sync_handler (bus, bench_sync_handler, run, NULL);
+    gst_object_unref (bus);
+
+    return pipeline;
+}
+
+/* waits for the end of a pipeline, returns FALSE if it failed */
+static gboolean
+bench_pipeline_wait (const BenchCase *c, GstElement *pipeline)
+{
+    GstBus *bus = gst_element_get_bus (pipeline);
+    GstMessage *msg;
+    gboolean ok;
+
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    ok = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+    if (!ok) {
+        GError *err = NULL;
+
+        gst_message_parse_error (msg, &err, NULL);
+        g_printerr ("%dx%d %s: %s\n", c->width, c->height, c->format,
+                    err->message);
+        g_error_free (err);
+    }
+    gst_message_unref (msg);
+    gst_object_unref (bus);
+
+    return ok;
+}
+
+static gboolean
+bench_merge_stage (GQuark field_id, const GValue *value, gpointer user_data)
+{
+    GstStructure *total = user_data;
+    const gchar *name = g_quark_to_string (field_id);
+    guint64 sum = 0;
+
+    gst_structure_get_uint64 (total, name, &sum);
+    gst_structure_set (total, name, G_TYPE_UINT64,
+                       sum + g_value_get_uint64 (value), NULL);
+
+    return TRUE;
+}
+
+/* runs one case with all its instances at the same time, returns FALSE
+ * if any pipeline failed */
+static gboolean
+bench_run_case (const BenchCase *c)
+{
+    GstElement **pipelines = g_new0 (GstElement *, c->instances);
+    BenchRun *runs = g_new0 (BenchRun, c->instances);
+    GstStructure *sums = gst_structure_new_empty ("stages");
+    GstClockTime cpu_first = GST_CLOCK_TIME_NONE;
+    GstClockTime cpu_last = 0;
+    GstClockTime jitter = 0;
+    GstClockTime max_jitter = 0;
+    gdouble fps = 0.0;
+    gdouble min_fps = G_MAXDOUBLE;
+    guint64 measured = 0;
+    BenchPrint print;
+    GString *json;
+    gboolean ok = TRUE;
+    gint i;
+
+    for (i = 0; i < c->instances && ok; i++) {
+        pipelines[i] = bench_pipeline_new (c, &runs[i]);
+        ok = pipelines[i] != NULL;
+    }
+
+    for (i = 0; i < c->instances && ok; i++)
+        gst_element_set_state (pipelines[i], GST_STATE_PLAYING);
+    for (i = 0; i < c->instances && ok; i++)
+        ok = bench_pipeline_wait (c, pipelines[i]);
+
+    for (i = 0; i < c->instances; i++) {
+        if (!pipelines[i])
+            continue;
+
+        gst_element_set_state (pipelines[i], GST_STATE_NULL);
+        gst_object_unref (pipelines[i]);
+    }
+
+    for (i = 0; i < c->instances && ok; i++) {
+        BenchRun *run = &runs[i];
+        gdouble run_fps = bench_run_fps (run);
+        GstClockTime run_jitter = bench_run_jitter (run);
+
+        ok = run->measured > 0;
+        fps += run_fps;
+        min_fps = MIN (min_fps, run_fps);
+        jitter += run_jitter;
+        max_jitter = MAX (max_jitter, run_jitter);
+        measured += run->measured;
+        /* the process cpu time while any instance was measured */
+        cpu_first = MIN (cpu_first, run->cpu_first);
+        cpu_last = MAX (cpu_last, run->cpu_last);
+        gst_structure_foreach (run->sums, bench_merge_stage, sums);
+    }
+
+    json = g_string_new (NULL);
+    g_string_append_printf (json, "{\"backend\": \"%s\", \"width\": %d, "
+                            "\"height\": %d, \"format\": \"%s\", "
+                            "\"deinterlace\": %s, \"window-width\": %d, "
+                            "\"window-height\": %d, \"instances\": %d",
+                            c->backend, c->width, c->height, c->format,
+                            c->deinterlace ? "true" : "false",
+                            c->window_width, c->window_height,
+                            c->instances);
+    if (ok) {
+        g_string_append_printf (json, ", \"frames\": %" G_GUINT64_FORMAT
+                                ", \"fps\": %.2f, \"min-fps\": %.2f, "
+                                "\"jitter\": %" G_GUINT64_FORMAT
+                                ", \"max-jitter\": %" G_GUINT64_FORMAT
+                                ", \"cpu-per-frame\": %" G_GUINT64_FORMAT
+                                ", \"stages\": {",
+                                measured, fps, min_fps,
+                                jitter / c->instances, max_jitter,
+                                (cpu_last - cpu_first) / measured);
+        print.json = json;
+        print.frames = measured;
+        gst_structure_foreach (sums, bench_print_stage, &print);
+        g_string_append (json, "}");
+    } else {
+        g_string_append (json, ", \"error\": true");
+    }
+    g_string_append (json, "}");
+    g_print ("%s\n", json->str);
+    fflush (stdout);
+
+    g_string_free (json, TRUE);
+    gst_structure_free (sums);
+    for (i = 0; i < c->instances; i++)
+        if (runs[i].sums)
+            gst_structure_free (runs[i].sums);
+    g_free (runs);
+    g_free (pipelines);
+
+    return ok;
+}
+
+int
+main (int argc, char *argv[])
+{
+    GOptionContext *ctx;
+    GError *err = NULL;
+    gchar **resolutions, **formats, **modes, **windows, **instances;
+    gchar **r, **f, **d, **w, **n;
+    gboolean ok = TRUE;
+
+    ctx = g_option_context_new ("- measure the glessink render path");
+    g_option_context_add_main_entries (ctx, bench_options, NULL);
+    g_option_context_add_group (ctx, gst_init_get_option_group ());
+    if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+        g_printerr ("%s\n", err->message);
+        g_error_free (err);
+        return 1;
+    }
+    g_option_context_free (ctx);
+
+    resolutions = g_strsplit (opt_resolutions ? opt_resolutions :
+                              "sd,720p,1080p,4k", ",", -1);
+    formats = g_strsplit (opt_formats ? opt_formats : "I420", ",", -1);
+    modes = g_strsplit (opt_deinterlace ? opt_deinterlace : "on,off",
+                        ",", -1);
+    windows = g_strsplit (opt_windows ? opt_windows :
+                          "720x576,1920x1080", ",", -1);
+    instances = g_strsplit (opt_instances ? opt_instances : "1", ",", -1);
+
+    for (r = resolutions; *r; r++)
+    for (f = formats; *f; f++)
+    for (d = modes; *d; d++)
+    for (w = windows; *w; w++)
+    for (n = instances; *n; n++) {
+        BenchCase c;
+
+        c.backend = opt_backend ? opt_backend : "pbuffer";
+        c.format = *f;
+        c.deinterlace = g_strcmp0 (*d, "off") != 0;
+        c.instances = atoi (*n);
+        if (c.instances < 1) {
+            g_printerr ("Invalid number of instances %s\n", *n);
+            ok = FALSE;
+            continue;
+        }
+        if (!bench_parse_size (*r, &c.width, &c.height) ||
+            !bench_parse_size (*w, &c.window_width, &c.window_height)) {
+            g_printerr ("Invalid size %s or %s\n", *r, *w);
+            ok = FALSE;
+            continue;
+        }
+        if (gst_video_format_from_string (c.format) ==
+            GST_VIDEO_FORMAT_UNKNOWN) {
+            g_printerr ("Unknown format %s\n", c.format);
+            ok = FALSE;
+            continue;
+        }
+
+        ok &= bench_run_case (&c);
+    }
+
+    g_strfreev (resolutions);
+    g_strfreev (formats);
+    g_strfreev (modes);
+    g_strfreev (windows);
+    g_strfreev (instances);
+
+    return ok ? 0 : 1;
+}
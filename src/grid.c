@@ -0,0 +1,411 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <GLES2/gl2.h>
+
+#include "grid.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+/* FIXME: Should be part of the GLES2 headers */
+#ifndef GL_UNPACK_ROW_LENGTH_EXT
+#define GL_UNPACK_ROW_LENGTH_EXT                                0x0CF2
+#endif
+#ifndef GL_RED_EXT
+#define GL_RED_EXT                                              0x1903
+#define GL_RG_EXT                                               0x8227
+#endif
+#ifndef GL_R16_EXT
+#define GL_R16_EXT                                              0x822A
+#define GL_RG16_EXT                                             0x822C
+#endif
+
+/* how one plane of a layout is stored in a texture */
+typedef struct
+{
+    GLint internal_format;
+    GLenum format;
+    GLenum type;
+    /* bytes per texel and frame pixels per texel in both directions */
+    gint bytes;
+    gint subsampling;
+} GridPlane;
+
+/* defines for the yuv programs by layout, with byte pairs and with 16 bit
+ * textures. Sampled 16 bit values are normalized to 65535, YUV_SCALE
+ * brings them to the range of the layout */
+static const gchar *grid_defines[][2] = {
+    /* GRID_FORMAT_I420 */
+    { NULL, NULL },
+    /* GRID_FORMAT_I420_10 */
+    {
+        "#define YUV_16BIT\n"
+        "#define YUV_BYTE_PAIRS\n"
+        "#define YUV_SCALE (65535.0 / 1023.0)\n",
+        "#define YUV_16BIT\n"
+        "#define YUV_SCALE (65535.0 / 1023.0)\n"
+    },
+    /* GRID_FORMAT_P010 */
+    {
+        "#define YUV_16BIT\n"
+        "#define YUV_BYTE_PAIRS\n"
+        "#define YUV_SEMIPLANAR\n"
+        "#define YUV_SCALE (65535.0 / 65472.0)\n",
+        "#define YUV_16BIT\n"
+        "#define YUV_SEMIPLANAR\n"
+        "#define YUV_SCALE (65535.0 / 65472.0)\n"
+    },
+    /* GRID_FORMAT_I420_PACKED, when it falls back to a texture per plane.
+     * The packed defines depend on the frame height */
+    { NULL, NULL }
+};
+
+/* position and texture coordinate of the four corners of a cell */
+#define CELL_FLOATS 16
+
+static GLuint
+gl_grid_texture (void)
+{
+    GLuint tex_id = 0;
+
+    glGenTextures (1, &tex_id);
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return tex_id;
+}
+
+static guint
+gl_grid_planes (GstGLESGrid *grid)
+{
+    if (grid->packed)
+        return 1;
+    return grid->format == GRID_FORMAT_P010 ? 2 : 3;
+}
+
+static void
+gl_grid_plane (GstGLESGrid *grid, guint plane, GridPlane *p)
+{
+    p->subsampling = plane ? 2 : 1;
+
+    if (grid->format == GRID_FORMAT_I420 ||
+        grid->format == GRID_FORMAT_I420_PACKED) {
+        p->internal_format = GL_LUMINANCE;
+        p->format = GL_LUMINANCE;
+        p->type = GL_UNSIGNED_BYTE;
+        p->bytes = 1;
+    } else if (grid->format == GRID_FORMAT_P010 && plane == 1) {
+        /* u and v of a texel next to each other */
+        p->internal_format = grid->norm16 ? GL_RG16_EXT : GL_RGBA;
+        p->format = grid->norm16 ? GL_RG_EXT : GL_RGBA;
+        p->type = grid->norm16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+        p->bytes = 4;
+    } else {
+        /* without 16 bit textures the low byte of a sample ends up in
+         * luminance and the high byte in alpha */
+        p->internal_format = grid->norm16 ? GL_R16_EXT : GL_LUMINANCE_ALPHA;
+        p->format = grid->norm16 ? GL_RED_EXT : GL_LUMINANCE_ALPHA;
+        p->type = grid->norm16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+        p->bytes = 2;
+    }
+}
+
+static void
+gl_grid_alloc_plane (GLuint tex_id, const GridPlane *p, gint width,
+                     gint height)
+{
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+    glTexImage2D (GL_TEXTURE_2D, 0, p->internal_format,
+                  width / p->subsampling, height / p->subsampling, 0,
+                  p->format, p->type, NULL);
+}
+
+/* the texture of a cell that holds a plane */
+static GLuint *
+gl_grid_cell_texture (GstGLESGridCell *cell, guint plane)
+{
+    GstGLESTexture *textures[] = { &cell->y_tex, &cell->u_tex, &cell->v_tex };
+    return &textures[plane]->id;
+}
+
+/* the packed layout addresses rows of tall frames, which mediump can't
+ * tell apart */
+static gboolean
+gl_grid_highp (void)
+{
+    GLint range[2];
+    GLint precision = 0;
+
+    glGetShaderPrecisionFormat (GL_FRAGMENT_SHADER, GL_HIGH_FLOAT, range,
+                                &precision);
+    return precision > 0;
+}
+
+/* splits length into count spans of even size, which the chroma planes
+ * need, that are at most max long including the border on both sides */
+static guint
+gl_grid_split (gint length, gint max, gint *span)
+{
+    gint usable = (max - 2 * GRID_BORDER) & ~1;
+    guint count;
+
+    if (length <= max) {
+        *span = length;
+        return 1;
+    }
+
+    count = (length + usable - 1) / usable;
+    *span = ((length + count - 1) / count + 1) & ~1;
+    return count;
+}
+
+/* writes the corners of a cell. Positions cover the part of the frame
+ * the cell is drawn for, texture coordinates the same part within the
+ * cell textures. Like the fullscreen quad the first row ends up at the
+ * top of the framebuffer */
+static void
+gl_grid_cell_vertices (GstGLESGrid *grid, GstGLESGridCell *cell,
+                       gint x0, gint y0, gint x1, gint y1, GLfloat *v)
+{
+    GLfloat left = -1.0f + 2.0f * x0 / grid->width;
+    GLfloat right = -1.0f + 2.0f * x1 / grid->width;
+    GLfloat top = 1.0f - 2.0f * y0 / grid->height;
+    GLfloat bottom = 1.0f - 2.0f * y1 / grid->height;
+    GLfloat s0 = (GLfloat) (x0 - cell->x) / cell->width;
+    GLfloat s1 = (GLfloat) (x1 - cell->x) / cell->width;
+    GLfloat t0 = (GLfloat) (y0 - cell->y) / cell->height;
+    GLfloat t1 = (GLfloat) (y1 - cell->y) / cell->height;
+    const GLfloat corners[CELL_FLOATS] = {
+        left, bottom, s0, t1,
+        right, bottom, s1, t1,
+        right, top, s1, t0,
+        left, top, s0, t0
+    };
+
+    memcpy (v, corners, sizeof (corners));
+}
+
+void
+gl_grid_alloc (GstGLESGrid *grid, gint width, gint height, gint max_size,
+               GstGLESGridFormat format)
+{
+    const gchar *extensions = (const gchar *) glGetString (GL_EXTENSIONS);
+    const gchar *version = (const gchar *) glGetString (GL_VERSION);
+    gboolean es3 = version && g_str_has_prefix (version, "OpenGL ES 3");
+    GridPlane planes[3];
+    GLfloat *vertices;
+    gint span_x, span_y;
+    guint columns, rows;
+    guint i, j, k;
+
+    gl_grid_free (grid);
+
+    columns = gl_grid_split (width, max_size, &span_x);
+    rows = gl_grid_split (height, max_size, &span_y);
+    if (columns * rows > 1)
+        GST_INFO ("Frame of %dx%d exceeds textures of %d, split into "
+                  "%ux%u cells", width, height, max_size, columns, rows);
+
+    grid->cells = g_new0 (GstGLESGridCell, columns * rows);
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->width = width;
+    grid->height = height;
+    grid->format = format;
+    grid->row_length = es3 ||
+            (extensions && strstr (extensions, "GL_EXT_unpack_subimage"));
+    grid->norm16 = es3 && extensions &&
+            strstr (extensions, "GL_EXT_texture_norm16");
+    grid->packed = format == GRID_FORMAT_I420_PACKED &&
+            columns * rows == 1 && height / 2 * 3 <= max_size &&
+            gl_grid_highp ();
+    if (grid->packed)
+        grid->packed_defines = g_strdup_printf ("#define YUV_PACKED\n"
+                                                "#define PACKED_HEIGHT %d.0\n",
+                                                height);
+    else if (format == GRID_FORMAT_I420_PACKED)
+        GST_INFO ("Frame of %dx%d uploaded as separate planes", width,
+                  height);
+
+    for (k = 0; k < gl_grid_planes (grid); k++)
+        gl_grid_plane (grid, k, &planes[k]);
+
+    vertices = g_new (GLfloat, columns * rows * CELL_FLOATS);
+
+    for (j = 0; j < rows; j++) {
+        gint y0 = j * span_y;
+        gint y1 = MIN (height, y0 + span_y);
+
+        for (i = 0; i < columns; i++) {
+            GstGLESGridCell *cell = &grid->cells[j * columns + i];
+            gint x0 = i * span_x;
+            gint x1 = MIN (width, x0 + span_x);
+
+            cell->x = MAX (0, x0 - GRID_BORDER);
+            cell->y = MAX (0, y0 - GRID_BORDER);
+            cell->width = MIN (width, x1 + GRID_BORDER) - cell->x;
+            cell->height = MIN (height, y1 + GRID_BORDER) - cell->y;
+
+            for (k = 0; k < gl_grid_planes (grid); k++) {
+                GLuint *tex_id = gl_grid_cell_texture (cell, k);
+
+                *tex_id = gl_grid_texture ();
+                gl_grid_alloc_plane (*tex_id, &planes[k], cell->width,
+                                     grid->packed ? cell->height / 2 * 3 :
+                                                    cell->height);
+            }
+
+            gl_grid_cell_vertices (grid, cell, x0, y0, x1, y1,
+                    &vertices[(j * columns + i) * CELL_FLOATS]);
+        }
+    }
+
+    glGenBuffers (1, &grid->vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, grid->vbo);
+    glBufferData (GL_ARRAY_BUFFER,
+                  columns * rows * CELL_FLOATS * sizeof (GLfloat),
+                  vertices, GL_STATIC_DRAW);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    g_free (vertices);
+}
+
+void
+gl_grid_free (GstGLESGrid *grid)
+{
+    guint i;
+
+    for (i = 0; i < grid->columns * grid->rows; i++) {
+        const GLuint textures[] = {
+            grid->cells[i].y_tex.id,
+            grid->cells[i].u_tex.id,
+            grid->cells[i].v_tex.id
+        };
+
+        glDeleteTextures (gl_grid_planes (grid), textures);
+    }
+
+    if (grid->vbo)
+        glDeleteBuffers (1, &grid->vbo);
+
+    g_free (grid->packed_defines);
+    g_free (grid->cells);
+    memset (grid, 0, sizeof (GstGLESGrid));
+}
+
+/* uploads the part of a plane a cell holds. Every cell is a texture of
+ * its own, so the driver can pipeline the transfers */
+static void
+gl_grid_upload_plane (GstGLESGrid *grid, GstGLESState *state,
+                      GstGLESGridCell *cell, guint plane,
+                      const guint8 *data, gint stride)
+{
+    GridPlane p;
+    gint x, y, width, height;
+    gint i;
+
+    gl_grid_plane (grid, plane, &p);
+    x = cell->x / p.subsampling;
+    y = cell->y / p.subsampling;
+    width = cell->width / p.subsampling;
+    height = cell->height / p.subsampling;
+
+    data += y * stride + x * p.bytes;
+
+    gl_state_bind_texture (state, plane, *gl_grid_cell_texture (cell, plane));
+    if (stride == width * p.bytes) {
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, width, height,
+                         p.format, p.type, data);
+    } else if (grid->row_length && stride % p.bytes == 0) {
+        glPixelStorei (GL_UNPACK_ROW_LENGTH_EXT, stride / p.bytes);
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, width, height,
+                         p.format, p.type, data);
+        glPixelStorei (GL_UNPACK_ROW_LENGTH_EXT, 0);
+    } else {
+        for (i = 0; i < height; i++)
+            glTexSubImage2D (GL_TEXTURE_2D, 0, 0, i, width, 1,
+                             p.format, p.type, data + i * stride);
+    }
+}
+
+void
+gl_grid_upload (GstGLESGrid *grid, GstGLESState *state,
+                const guint8 *planes[3], const gint strides[3])
+{
+    guint i, k;
+
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+
+    /* the planes follow each other, so one upload takes all of them */
+    if (grid->packed) {
+        gl_state_bind_texture (state, 0, grid->cells[0].y_tex.id);
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, grid->width,
+                         grid->height / 2 * 3, GL_LUMINANCE,
+                         GL_UNSIGNED_BYTE, planes[0]);
+        return;
+    }
+
+    for (i = 0; i < grid->columns * grid->rows; i++)
+        for (k = 0; k < gl_grid_planes (grid); k++)
+            gl_grid_upload_plane (grid, state, &grid->cells[i], k,
+                                  planes[k], strides[k]);
+}
+
+const gchar *
+gl_grid_shader_defines (GstGLESGrid *grid)
+{
+    if (grid->packed)
+        return grid->packed_defines;
+    return grid_defines[grid->format][grid->norm16];
+}
+
+void
+gl_grid_draw (GstGLESGrid *grid, GstGLESState *state, GLint line_height_loc,
+              GLuint ibo)
+{
+    guint i;
+
+    for (i = 0; i < grid->columns * grid->rows; i++) {
+        GstGLESGridCell *cell = &grid->cells[i];
+        gsize offset = i * CELL_FLOATS * sizeof (GLfloat);
+        guint k;
+
+        for (k = 0; k < gl_grid_planes (grid); k++)
+            gl_state_bind_texture (state, k, *gl_grid_cell_texture (cell, k));
+
+        /* texture coordinates are relative to the cell, so is the
+         * distance to the next line */
+        if (line_height_loc >= 0)
+            glUniform1f (line_height_loc, 1.0f / cell->height);
+
+        gl_state_quad_attributes (state, grid->vbo, ibo, offset);
+        glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT,
+                        (const GLvoid *) 0);
+    }
+}
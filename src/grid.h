@@ -0,0 +1,119 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GRID_H__
+#define _GRID_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+
+#include "shader.h"
+#include "state.h"
+
+/* rows and columns a cell shares with its neighbours, so the samples
+ * the deinterlacer and the chroma take across a cell edge are there */
+#define GRID_BORDER 4
+
+typedef enum _GstGLESGridFormat    GstGLESGridFormat;
+typedef struct _GstGLESGridCell    GstGLESGridCell;
+typedef struct _GstGLESGrid        GstGLESGrid;
+
+/* layouts of the yuv planes, all of them with 4:2:0 chroma */
+enum _GstGLESGridFormat {
+    GRID_FORMAT_I420 = 0,
+    /* 16 bit little endian samples, the value in the low bits */
+    GRID_FORMAT_I420_10,
+    /* 16 bit little endian samples, the value in the high bits, and
+     * interleaved u and v in the second plane */
+    GRID_FORMAT_P010,
+    /* 8 bit I420 with the planes back to back and without padding, so
+     * the whole frame can go up as one texture */
+    GRID_FORMAT_I420_PACKED
+};
+
+struct _GstGLESGridCell
+{
+    /* luma rectangle of the frame the textures hold, including the
+     * border shared with the neighbouring cells */
+    gint x;
+    gint y;
+    gint width;
+    gint height;
+
+    GstGLESTexture y_tex;
+    GstGLESTexture u_tex;
+    GstGLESTexture v_tex;
+};
+
+/* the I420 planes of a frame as a grid of textures, each no larger than
+ * the GL allows. Frames that fit are a grid of one cell */
+struct _GstGLESGrid
+{
+    GstGLESGridCell *cells;
+    guint columns;
+    guint rows;
+
+    /* frame size and layout the cells are allocated for */
+    gint width;
+    gint height;
+    GstGLESGridFormat format;
+
+    /* 16 bit samples are uploaded to 16 bit normalized textures if the
+     * GL has them, else as pairs of bytes the shader recombines */
+    gboolean norm16;
+
+    /* one quad per cell, drawn with the quad indices of the pool */
+    GLuint vbo;
+
+    /* GL_UNPACK_ROW_LENGTH is available to upload part of a plane */
+    gboolean row_length;
+
+    /* a GRID_FORMAT_I420_PACKED frame fits one texture, which holds the
+     * luma rows followed by the u and v rows, two chroma rows side by
+     * side in a texture row. It is the y texture of the only cell, the
+     * shader finds the planes by the defines */
+    gboolean packed;
+    gchar *packed_defines;
+};
+
+/* (re)allocates the cells for a frame size and layout, max_size is the
+ * largest texture the GL supports. A GRID_FORMAT_I420_PACKED frame that
+ * does not fit one texture falls back to a texture per plane */
+void gl_grid_alloc (GstGLESGrid *grid, gint width, gint height,
+                    gint max_size, GstGLESGridFormat format);
+void gl_grid_free (GstGLESGrid *grid);
+
+/* uploads the planes of a frame into the cells, strides are in bytes.
+ * P010 only has the first two planes */
+void gl_grid_upload (GstGLESGrid *grid, GstGLESState *state,
+                     const guint8 *planes[3], const gint strides[3]);
+
+/* defines a yuv program has to be built with to sample the cells, NULL
+ * for 8 bit I420 */
+const gchar *gl_grid_shader_defines (GstGLESGrid *grid);
+
+/* draws every cell with the yuv program in use, its samplers have to
+ * use units 0 to 2, only unit 0 for a packed frame. line_height_loc is
+ * -1 for programs that do not deinterlace */
+void gl_grid_draw (GstGLESGrid *grid, GstGLESState *state,
+                   GLint line_height_loc, GLuint ibo);
+
+#endif
@@ -0,0 +1,1233 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-glescompositor
+ *
+ * Renders any number of I420 streams as tiles into one window, with one
+ * buffer swap per refresh for all of them. Each request pad places its
+ * stream with the xpos, ypos, width, height, zorder and alpha
+ * properties. A tile is only converted again when its input changes and
+ * nothing is drawn while no input changes.
+ *
+ * Unlike a #GstBaseSink the compositor does not preroll: going to PAUSED
+ * completes without waiting for a buffer, so no frame is shown before
+ * PLAYING. In PAUSED the streaming threads block until the pipeline
+ * plays again.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 glescompositor name=c \
+ *     videotestsrc ! c.sink_0 \
+ *     videotestsrc pattern=ball ! c.sink_1 c.sink_1::xpos=640
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "gstglescompositor.h"
+
+#if GST_CHECK_VERSION(1, 0, 0)
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+#define DEFAULT_WIDTH 1280
+#define DEFAULT_HEIGHT 720
+#define DEFAULT_PAD_ALPHA 1.0
+
+/* how often window events are looked at while no input changes */
+#define EVENT_POLL_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
+
+enum
+{
+  PROP_0,
+  PROP_WIDTH,
+  PROP_HEIGHT
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_XPOS,
+  PROP_PAD_YPOS,
+  PROP_PAD_WIDTH,
+  PROP_PAD_HEIGHT,
+  PROP_PAD_ZORDER,
+  PROP_PAD_ALPHA
+};
+
+static GstStaticPadTemplate gles_compositor_sink_factory =
+    GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("I420"))
+    );
+
+static void gst_gles_compositor_child_proxy_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE (GstGLESCompositorPad, gst_gles_compositor_pad, GST_TYPE_PAD);
+G_DEFINE_TYPE_WITH_CODE (GstGLESCompositor, gst_gles_compositor,
+    GST_TYPE_ELEMENT,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY,
+    gst_gles_compositor_child_proxy_init));
+
+/* wakes the gl thread up to draw a new frame */
+static void
+gst_gles_compositor_mark_dirty (GstGLESCompositor *comp)
+{
+    g_mutex_lock (&comp->lock);
+    comp->dirty = TRUE;
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+}
+
+/* uploads a frame and converts it into the rgb texture of its tile */
+static void
+gl_tile_convert (GstGLESCompositor *comp, GstGLESTile *tile,
+                 GstBuffer *buf, GstVideoInfo *info)
+{
+    GstVideoFrame frame;
+
+    if (!gst_video_frame_map (&frame, info, buf, GST_MAP_READ)) {
+        GST_WARNING_OBJECT (comp, "Failed to map buffer data");
+        return;
+    }
+
+    gl_tile_upload (tile, &frame);
+    gst_video_frame_unmap (&frame);
+
+    gl_tile_render (tile, &comp->convert, comp->quad_vbo, comp->quad_ibo);
+}
+
+/* Compositing */
+
+typedef struct
+{
+    GstGLESCompositorPad *pad;
+    GstGLESTile *tile;
+    GstVideoRectangle rect;
+    guint zorder;
+    gdouble alpha;
+    GstBuffer *buf;
+    GstVideoInfo info;
+} GstGLESTileDraw;
+
+static gint
+gst_gles_tile_draw_compare (gconstpointer a, gconstpointer b)
+{
+    const GstGLESTileDraw *da = a;
+    const GstGLESTileDraw *db = b;
+
+    return da->zorder < db->zorder ? -1 : da->zorder > db->zorder;
+}
+
+/* takes the new frames and the geometry of every pad, called with the
+ * compositor lock held */
+static GArray *
+gst_gles_compositor_snapshot (GstGLESCompositor *comp)
+{
+    GArray *draws = g_array_new (FALSE, TRUE, sizeof (GstGLESTileDraw));
+    GList *l;
+
+    GST_OBJECT_LOCK (comp);
+    for (l = GST_ELEMENT (comp)->sinkpads; l; l = l->next) {
+        GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (l->data);
+        GstGLESTileDraw draw = { NULL, };
+
+        if (!pad->tile)
+            continue;
+
+        /* release_pad may clear pad->tile once the lock is dropped, the
+         * tile itself is only freed by the GL thread after drawing */
+        draw.pad = gst_object_ref (pad);
+        draw.tile = pad->tile;
+        draw.buf = pad->pending;
+        draw.info = pad->pending_info;
+        pad->pending = NULL;
+
+        GST_OBJECT_LOCK (pad);
+        draw.rect.x = pad->xpos;
+        draw.rect.y = pad->ypos;
+        draw.rect.w = pad->width;
+        draw.rect.h = pad->height;
+        draw.zorder = pad->zorder;
+        draw.alpha = pad->alpha;
+        GST_OBJECT_UNLOCK (pad);
+
+        g_array_append_val (draws, draw);
+    }
+    GST_OBJECT_UNLOCK (comp);
+
+    g_array_sort (draws, gst_gles_tile_draw_compare);
+
+    return draws;
+}
+
+static void
+gl_draw_tile (GstGLESCompositor *comp, GstGLESTileDraw *draw)
+{
+    const GLfloat vertices[] =
+    {
+        -1.0f, -1.0f,
+        0.0f, 0.0f,
+
+        1.0f, -1.0f,
+        1.0f, 0.0f,
+
+        1.0f, 1.0f,
+        1.0f, 1.0f,
+
+        -1.0f, 1.0f,
+        0.0f, 1.0f,
+    };
+    const GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+    GstGLESTile *tile = draw->tile;
+    GstVideoRectangle rect = draw->rect;
+
+    if (!tile->valid || draw->alpha <= 0.0)
+        return;
+
+    if (rect.w <= 0)
+        rect.w = tile->width;
+    if (rect.h <= 0)
+        rect.h = tile->height;
+
+    /* the quad fills the viewport, so the viewport places the tile */
+    glViewport (rect.x, comp->window_height - rect.y - rect.h,
+                rect.w, rect.h);
+
+    glVertexAttribPointer (comp->copy.position_loc, 2, GL_FLOAT, GL_FALSE,
+                           4 * sizeof (GLfloat), vertices);
+    glVertexAttribPointer (comp->copy.texcoord_loc, 2, GL_FLOAT, GL_FALSE,
+                           4 * sizeof (GLfloat), &vertices[2]);
+    glEnableVertexAttribArray (comp->copy.position_loc);
+    glEnableVertexAttribArray (comp->copy.texcoord_loc);
+
+    glBindTexture (GL_TEXTURE_2D, tile->rgb_tex.id);
+    glBlendColor (0.0f, 0.0f, 0.0f, draw->alpha);
+
+    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+}
+
+/* converts the tiles with new input and draws all of them with a
+ * single swap */
+static void
+gl_composite (GstGLESCompositor *comp, GArray *draws)
+{
+    guint i;
+
+    for (i = 0; i < draws->len; i++) {
+        GstGLESTileDraw *draw = &g_array_index (draws, GstGLESTileDraw, i);
+
+        if (draw->buf)
+            gl_tile_convert (comp, draw->tile, draw->buf, &draw->info);
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+    glViewport (0, 0, comp->window_width, comp->window_height);
+    glClear (GL_COLOR_BUFFER_BIT);
+
+    glUseProgram (comp->copy.program);
+    glActiveTexture (GL_TEXTURE3);
+    glUniform1i (comp->copy_tex_loc, 3);
+
+    glEnable (GL_BLEND);
+    glBlendFunc (GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    for (i = 0; i < draws->len; i++)
+        gl_draw_tile (comp, &g_array_index (draws, GstGLESTileDraw, i));
+    glDisable (GL_BLEND);
+
+    eglSwapBuffers (comp->pool->display, comp->surface);
+}
+
+/* Window and context */
+
+static void
+x11_compositor_handle_events (GstGLESCompositor *comp)
+{
+    Display *display = (Display *) comp->pool->native_display;
+    XEvent xev;
+
+    XLockDisplay (display);
+    while (XCheckWindowEvent (display, comp->window, StructureNotifyMask,
+                              &xev)) {
+        if (xev.type == ConfigureNotify &&
+            (xev.xconfigure.width != comp->window_width ||
+             xev.xconfigure.height != comp->window_height)) {
+            comp->window_width = xev.xconfigure.width;
+            comp->window_height = xev.xconfigure.height;
+            g_mutex_lock (&comp->lock);
+            comp->dirty = TRUE;
+            g_mutex_unlock (&comp->lock);
+        }
+    }
+    XUnlockDisplay (display);
+}
+
+static gint
+gl_compositor_init (GstGLESCompositor *comp)
+{
+    const EGLint context_attribs[] =
+    {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    GstGLESPool *pool = comp->pool;
+    Display *display = pool->native_display;
+    XSetWindowAttributes swa;
+
+    XLockDisplay (display);
+    swa.event_mask = StructureNotifyMask;
+    comp->window = XCreateWindow (display, DefaultRootWindow (display),
+                                  0, 0, comp->width, comp->height, 0,
+                                  CopyFromParent, InputOutput,
+                                  CopyFromParent, CWEventMask, &swa);
+    XSetWindowBackgroundPixmap (display, comp->window, None);
+    XMapWindow (display, comp->window);
+    XStoreName (display, comp->window, "GLESCompositor");
+    XUnlockDisplay (display);
+    comp->window_width = comp->width;
+    comp->window_height = comp->height;
+
+    /* the pool config keeps the context compatible with the group */
+    comp->surface = eglCreateWindowSurface (pool->display, pool->config,
+                                            comp->window, NULL);
+    if (comp->surface == EGL_NO_SURFACE) {
+        GST_ERROR_OBJECT (comp, "Could not create EGL surface");
+        return -1;
+    }
+
+    comp->shared = pool->context != NULL;
+    comp->context = eglCreateContext (pool->display, pool->config,
+                                      comp->shared ? pool->context :
+                                      EGL_NO_CONTEXT, context_attribs);
+    if (comp->context == EGL_NO_CONTEXT) {
+        GST_ERROR_OBJECT (comp, "Could not create EGL context");
+        return -1;
+    }
+
+    if (!eglMakeCurrent (pool->display, comp->surface, comp->surface,
+                         comp->context)) {
+        GST_ERROR_OBJECT (comp, "Could not set EGL context to current");
+        return -1;
+    }
+
+    /* every refresh gets at most one swap */
+    eglSwapInterval (pool->display, 1);
+
+    if (gl_init_shader (GST_ELEMENT (comp), &comp->convert,
+                        SHADER_YUV_RGB) < 0 ||
+        gl_init_shader (GST_ELEMENT (comp), &comp->copy, SHADER_COPY) < 0)
+        return -1;
+
+    glUseProgram (comp->convert.program);
+    glUniform1i (glGetUniformLocation (comp->convert.program, "s_ytex"), 0);
+    glUniform1i (glGetUniformLocation (comp->convert.program, "s_utex"), 1);
+    glUniform1i (glGetUniformLocation (comp->convert.program, "s_vtex"), 2);
+    comp->copy_tex_loc = glGetUniformLocation (comp->copy.program, "s_tex");
+
+    if (comp->shared)
+        gst_gles_pool_get_quad (pool, &comp->quad_vbo, &comp->quad_ibo);
+    else
+        gl_create_quad (&comp->quad_vbo, &comp->quad_ibo);
+
+    glClearColor (0.0, 0.0, 0.0, 1.0);
+
+    return 0;
+}
+
+static void
+gl_compositor_close (GstGLESCompositor *comp)
+{
+    GstGLESPool *pool = comp->pool;
+    Display *display = pool->native_display;
+    GList *l;
+
+    if (comp->context) {
+        GST_OBJECT_LOCK (comp);
+        for (l = GST_ELEMENT (comp)->sinkpads; l; l = l->next) {
+            GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (l->data);
+            if (pad->tile)
+                gl_tile_free (pad->tile);
+        }
+        GST_OBJECT_UNLOCK (comp);
+
+        if (!comp->shared && comp->quad_vbo) {
+            glDeleteBuffers (1, &comp->quad_vbo);
+            glDeleteBuffers (1, &comp->quad_ibo);
+        }
+        gl_delete_shader (&comp->convert);
+        gl_delete_shader (&comp->copy);
+
+        eglMakeCurrent (pool->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                        EGL_NO_CONTEXT);
+        eglDestroyContext (pool->display, comp->context);
+        comp->context = NULL;
+    }
+    comp->quad_vbo = 0;
+    comp->quad_ibo = 0;
+
+    if (comp->surface) {
+        eglDestroySurface (pool->display, comp->surface);
+        comp->surface = NULL;
+    }
+
+    if (comp->window) {
+        XLockDisplay (display);
+        XDestroyWindow (display, comp->window);
+        XSync (display, FALSE);
+        XUnlockDisplay (display);
+        comp->window = 0;
+    }
+}
+
+static void
+gl_compositor_free_dead_tiles (GstGLESCompositor *comp)
+{
+    GList *dead;
+    GList *l;
+
+    g_mutex_lock (&comp->lock);
+    dead = comp->dead_tiles;
+    comp->dead_tiles = NULL;
+    g_mutex_unlock (&comp->lock);
+
+    for (l = dead; l; l = l->next) {
+        gl_tile_free (l->data);
+        g_slice_free (GstGLESTile, l->data);
+    }
+    g_list_free (dead);
+}
+
+static gpointer
+gl_compositor_thread_proc (gpointer data)
+{
+    GstGLESCompositor *comp = GST_GLES_COMPOSITOR (data);
+    gboolean ready;
+
+    ready = gl_compositor_init (comp) == 0;
+
+    g_mutex_lock (&comp->lock);
+    comp->running = ready && comp->running;
+    comp->init_done = TRUE;
+    g_cond_broadcast (&comp->cond);
+
+    while (comp->running) {
+        GArray *draws;
+        guint i;
+
+        if (!comp->dirty) {
+            gint64 deadline = g_get_monotonic_time () + EVENT_POLL_INTERVAL;
+
+            g_cond_wait_until (&comp->cond, &comp->lock, deadline);
+            g_mutex_unlock (&comp->lock);
+            x11_compositor_handle_events (comp);
+            g_mutex_lock (&comp->lock);
+            continue;
+        }
+
+        comp->dirty = FALSE;
+        draws = gst_gles_compositor_snapshot (comp);
+        g_mutex_unlock (&comp->lock);
+
+        XLockDisplay ((Display *) comp->pool->native_display);
+        gl_composite (comp, draws);
+        XUnlockDisplay ((Display *) comp->pool->native_display);
+
+        /* only now, the snapshot may still reference released tiles */
+        gl_compositor_free_dead_tiles (comp);
+
+        for (i = 0; i < draws->len; i++) {
+            GstGLESTileDraw *draw = &g_array_index (draws, GstGLESTileDraw, i);
+
+            if (draw->buf)
+                gst_buffer_unref (draw->buf);
+            gst_object_unref (draw->pad);
+        }
+        g_array_free (draws, TRUE);
+
+        g_mutex_lock (&comp->lock);
+    }
+    g_mutex_unlock (&comp->lock);
+
+    if (!ready)
+        GST_ELEMENT_ERROR (comp, LIBRARY, INIT,
+                           ("Could not initialize GL context"), (NULL));
+
+    gl_compositor_free_dead_tiles (comp);
+    gl_compositor_close (comp);
+
+    return NULL;
+}
+
+static gboolean
+gst_gles_compositor_start (GstGLESCompositor *comp)
+{
+    gboolean created;
+    GError *error = NULL;
+
+    if (comp->app_pool)
+        comp->pool = gst_gles_pool_ref (comp->app_pool);
+    else
+        comp->pool = gst_gles_pool_get_default (GST_GLES_BACKEND_X11,
+                                                &created);
+    if (!comp->pool) {
+        GST_ELEMENT_ERROR (comp, RESOURCE, OPEN_READ_WRITE,
+                           ("Could not open display"), (NULL));
+        return FALSE;
+    }
+
+    comp->init_done = FALSE;
+    comp->running = TRUE;
+    comp->playing = FALSE;
+    comp->dirty = FALSE;
+    comp->thread = g_thread_try_new ("gl_compositor",
+                                     gl_compositor_thread_proc, comp,
+                                     &error);
+    if (!comp->thread) {
+        GST_ELEMENT_ERROR (comp, LIBRARY, INIT,
+                           ("Can't create render-thread"),
+                           ("%s", error ? error->message : "(unknown)"));
+        g_clear_error (&error);
+        gst_gles_pool_unref (comp->pool);
+        comp->pool = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* frees the tiles of pads released after the gl thread last looked,
+ * their gl objects went away with its context */
+static void
+gst_gles_compositor_drop_dead_tiles (GstGLESCompositor *comp)
+{
+    GList *dead;
+    GList *l;
+
+    g_mutex_lock (&comp->lock);
+    dead = comp->dead_tiles;
+    comp->dead_tiles = NULL;
+    g_mutex_unlock (&comp->lock);
+
+    for (l = dead; l; l = l->next)
+        g_slice_free (GstGLESTile, l->data);
+    g_list_free (dead);
+}
+
+static void
+gst_gles_compositor_stop (GstGLESCompositor *comp)
+{
+    GList *l;
+
+    if (!comp->thread)
+        return;
+
+    g_mutex_lock (&comp->lock);
+    comp->running = FALSE;
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+
+    g_thread_join (comp->thread);
+    g_mutex_lock (&comp->lock);
+    comp->thread = NULL;
+    g_mutex_unlock (&comp->lock);
+    gst_gles_compositor_drop_dead_tiles (comp);
+
+    GST_OBJECT_LOCK (comp);
+    for (l = GST_ELEMENT (comp)->sinkpads; l; l = l->next) {
+        GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (l->data);
+        gst_buffer_replace (&pad->pending, NULL);
+    }
+    GST_OBJECT_UNLOCK (comp);
+
+    gst_gles_pool_unref (comp->pool);
+    comp->pool = NULL;
+}
+
+/* Pads */
+
+/* sets the flushing flag of every pad and wakes them from clock waits */
+static void
+gst_gles_compositor_set_flushing (GstGLESCompositor *comp,
+                                  gboolean flushing)
+{
+    GList *l;
+
+    GST_OBJECT_LOCK (comp);
+    for (l = GST_ELEMENT (comp)->sinkpads; l; l = l->next) {
+        GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (l->data);
+
+        GST_OBJECT_LOCK (pad);
+        pad->flushing = flushing;
+        if (flushing && pad->clock_id)
+            gst_clock_id_unschedule (pad->clock_id);
+        GST_OBJECT_UNLOCK (pad);
+    }
+    GST_OBJECT_UNLOCK (comp);
+}
+
+/* switches between PLAYING and PAUSED, pads waiting for their buffer to
+ * be due wait for PLAYING again */
+static void
+gst_gles_compositor_set_playing (GstGLESCompositor *comp, gboolean playing)
+{
+    GList *l;
+
+    g_mutex_lock (&comp->lock);
+    comp->playing = playing;
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+
+    if (playing)
+        return;
+
+    GST_OBJECT_LOCK (comp);
+    for (l = GST_ELEMENT (comp)->sinkpads; l; l = l->next) {
+        GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (l->data);
+
+        GST_OBJECT_LOCK (pad);
+        if (pad->clock_id)
+            gst_clock_id_unschedule (pad->clock_id);
+        GST_OBJECT_UNLOCK (pad);
+    }
+    GST_OBJECT_UNLOCK (comp);
+}
+
+/* wakes a pad blocked in PAUSED after its flushing flag was set */
+static void
+gst_gles_compositor_wake (GstGLESCompositor *comp)
+{
+    g_mutex_lock (&comp->lock);
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+}
+
+/* blocks while PAUSED, returns FALSE when flushing or stopped */
+static gboolean
+gst_gles_compositor_pad_wait_playing (GstGLESCompositor *comp,
+                                      GstGLESCompositorPad *pad)
+{
+    gboolean flushing;
+
+    g_mutex_lock (&comp->lock);
+    for (;;) {
+        GST_OBJECT_LOCK (pad);
+        flushing = pad->flushing;
+        GST_OBJECT_UNLOCK (pad);
+
+        if (flushing || comp->playing || !comp->running)
+            break;
+        g_cond_wait (&comp->cond, &comp->lock);
+    }
+    flushing = flushing || !comp->running;
+    g_mutex_unlock (&comp->lock);
+
+    return !flushing;
+}
+
+/* waits for the clock until the buffer is due, unscheduled when flushing
+ * or paused */
+static GstClockReturn
+gst_gles_compositor_pad_wait_clock (GstGLESCompositor *comp,
+                                    GstGLESCompositorPad *pad,
+                                    GstBuffer *buf)
+{
+    GstClockTime running_time;
+    GstClockReturn ret;
+    GstClock *clock;
+    GstClockID id;
+
+    if (!GST_BUFFER_PTS_IS_VALID (buf))
+        return pad->flushing ? GST_CLOCK_UNSCHEDULED : GST_CLOCK_OK;
+
+    running_time = gst_segment_to_running_time (&pad->segment,
+                                                GST_FORMAT_TIME,
+                                                GST_BUFFER_PTS (buf));
+    clock = gst_element_get_clock (GST_ELEMENT (comp));
+    if (!clock || !GST_CLOCK_TIME_IS_VALID (running_time)) {
+        if (clock)
+            gst_object_unref (clock);
+        return pad->flushing ? GST_CLOCK_UNSCHEDULED : GST_CLOCK_OK;
+    }
+
+    /* set_playing unschedules under the pad lock after clearing playing,
+     * so a pause can't slip in between the check and the wait */
+    GST_OBJECT_LOCK (pad);
+    if (pad->flushing || !comp->playing) {
+        GST_OBJECT_UNLOCK (pad);
+        gst_object_unref (clock);
+        return GST_CLOCK_UNSCHEDULED;
+    }
+    id = gst_clock_new_single_shot_id (clock, running_time +
+            gst_element_get_base_time (GST_ELEMENT (comp)));
+    pad->clock_id = id;
+    GST_OBJECT_UNLOCK (pad);
+
+    ret = gst_clock_id_wait (id, NULL);
+
+    GST_OBJECT_LOCK (pad);
+    pad->clock_id = NULL;
+    GST_OBJECT_UNLOCK (pad);
+    gst_clock_id_unref (id);
+    gst_object_unref (clock);
+
+    return ret;
+}
+
+/* waits until the buffer is due in PLAYING, returns FALSE when
+ * flushing */
+static gboolean
+gst_gles_compositor_pad_wait (GstGLESCompositor *comp,
+                              GstGLESCompositorPad *pad, GstBuffer *buf)
+{
+    GstClockReturn ret;
+
+    /* a pause unschedules the wait, the base time changes on resume */
+    do {
+        if (!gst_gles_compositor_pad_wait_playing (comp, pad))
+            return FALSE;
+        ret = gst_gles_compositor_pad_wait_clock (comp, pad, buf);
+    } while (ret == GST_CLOCK_UNSCHEDULED && !pad->flushing);
+
+    return ret != GST_CLOCK_UNSCHEDULED;
+}
+
+static GstFlowReturn
+gst_gles_compositor_chain (GstPad *pad, GstObject *parent, GstBuffer *buf)
+{
+    GstGLESCompositor *comp = GST_GLES_COMPOSITOR (parent);
+    GstGLESCompositorPad *cpad = GST_GLES_COMPOSITOR_PAD (pad);
+
+    if (!cpad->have_info) {
+        gst_buffer_unref (buf);
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    if (!gst_gles_compositor_pad_wait (comp, cpad, buf)) {
+        gst_buffer_unref (buf);
+        return GST_FLOW_FLUSHING;
+    }
+
+    g_mutex_lock (&comp->lock);
+    while (!comp->init_done && comp->running)
+        g_cond_wait (&comp->cond, &comp->lock);
+    if (!comp->running) {
+        g_mutex_unlock (&comp->lock);
+        gst_buffer_unref (buf);
+        return GST_FLOW_FLUSHING;
+    }
+
+    /* the latest frame wins, the previous one was never shown */
+    if (cpad->pending)
+        gst_buffer_unref (cpad->pending);
+    cpad->pending = buf;
+    cpad->pending_info = cpad->info;
+    comp->dirty = TRUE;
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+gst_gles_compositor_all_eos (GstGLESCompositor *comp)
+{
+    gboolean eos = TRUE;
+    GList *l;
+
+    GST_OBJECT_LOCK (comp);
+    for (l = GST_ELEMENT (comp)->sinkpads; l && eos; l = l->next)
+        eos = GST_GLES_COMPOSITOR_PAD (l->data)->eos;
+    GST_OBJECT_UNLOCK (comp);
+
+    return eos;
+}
+
+static gboolean
+gst_gles_compositor_sink_event (GstPad *pad, GstObject *parent,
+                                GstEvent *event)
+{
+    GstGLESCompositor *comp = GST_GLES_COMPOSITOR (parent);
+    GstGLESCompositorPad *cpad = GST_GLES_COMPOSITOR_PAD (pad);
+    gboolean ret = TRUE;
+
+    switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+        GstCaps *caps;
+
+        gst_event_parse_caps (event, &caps);
+        cpad->have_info = gst_video_info_from_caps (&cpad->info, caps);
+        ret = cpad->have_info;
+        break;
+    }
+    case GST_EVENT_SEGMENT:
+        gst_event_copy_segment (event, &cpad->segment);
+        break;
+    case GST_EVENT_FLUSH_START:
+        GST_OBJECT_LOCK (cpad);
+        cpad->flushing = TRUE;
+        if (cpad->clock_id)
+            gst_clock_id_unschedule (cpad->clock_id);
+        GST_OBJECT_UNLOCK (cpad);
+        gst_gles_compositor_wake (comp);
+        break;
+    case GST_EVENT_FLUSH_STOP:
+        GST_OBJECT_LOCK (cpad);
+        cpad->flushing = FALSE;
+        GST_OBJECT_UNLOCK (cpad);
+        gst_segment_init (&cpad->segment, GST_FORMAT_TIME);
+        cpad->eos = FALSE;
+        break;
+    case GST_EVENT_EOS:
+        cpad->eos = TRUE;
+        if (gst_gles_compositor_all_eos (comp))
+            gst_element_post_message (GST_ELEMENT (comp),
+                                      gst_message_new_eos (parent));
+        break;
+    default:
+        break;
+    }
+
+    gst_event_unref (event);
+    return ret;
+}
+
+static GstPad *
+gst_gles_compositor_request_new_pad (GstElement *element,
+                                     GstPadTemplate *templ,
+                                     const gchar *req_name,
+                                     const GstCaps *caps)
+{
+    GstGLESCompositor *comp = GST_GLES_COMPOSITOR (element);
+    GstGLESCompositorPad *pad;
+    gchar *name;
+
+    GST_OBJECT_LOCK (comp);
+    if (req_name) {
+        name = g_strdup (req_name);
+    } else {
+        name = g_strdup_printf ("sink_%u", comp->next_pad_id);
+    }
+    comp->next_pad_id++;
+    GST_OBJECT_UNLOCK (comp);
+
+    pad = g_object_new (GST_TYPE_GLES_COMPOSITOR_PAD, "name", name,
+                        "direction", GST_PAD_SINK, "template", templ, NULL);
+    g_free (name);
+
+    gst_pad_set_chain_function (GST_PAD (pad),
+            GST_DEBUG_FUNCPTR (gst_gles_compositor_chain));
+    gst_pad_set_event_function (GST_PAD (pad),
+            GST_DEBUG_FUNCPTR (gst_gles_compositor_sink_event));
+    GST_PAD_SET_PROXY_ALLOCATION (pad);
+
+    if (!gst_element_add_pad (element, GST_PAD (pad))) {
+        gst_object_unref (pad);
+        return NULL;
+    }
+
+    gst_child_proxy_child_added (GST_CHILD_PROXY (comp), G_OBJECT (pad),
+                                 GST_OBJECT_NAME (pad));
+
+    return GST_PAD (pad);
+}
+
+static void
+gst_gles_compositor_release_pad (GstElement *element, GstPad *pad)
+{
+    GstGLESCompositor *comp = GST_GLES_COMPOSITOR (element);
+    GstGLESCompositorPad *cpad = GST_GLES_COMPOSITOR_PAD (pad);
+
+    /* the gl objects of the tile can only go away on the gl thread */
+    g_mutex_lock (&comp->lock);
+    if (comp->thread)
+        comp->dead_tiles = g_list_prepend (comp->dead_tiles, cpad->tile);
+    else
+        g_slice_free (GstGLESTile, cpad->tile);
+    cpad->tile = NULL;
+    gst_buffer_replace (&cpad->pending, NULL);
+    comp->dirty = TRUE;
+    g_cond_broadcast (&comp->cond);
+    g_mutex_unlock (&comp->lock);
+
+    gst_child_proxy_child_removed (GST_CHILD_PROXY (comp), G_OBJECT (pad),
+                                   GST_OBJECT_NAME (pad));
+    gst_element_remove_pad (element, pad);
+}
+
+static void
+gst_gles_compositor_pad_set_property (GObject *object, guint prop_id,
+                                      const GValue *value, GParamSpec *pspec)
+{
+  GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (object);
+  GstObject *parent;
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      pad->xpos = g_value_get_int (value);
+      break;
+    case PROP_PAD_YPOS:
+      pad->ypos = g_value_get_int (value);
+      break;
+    case PROP_PAD_WIDTH:
+      pad->width = g_value_get_int (value);
+      break;
+    case PROP_PAD_HEIGHT:
+      pad->height = g_value_get_int (value);
+      break;
+    case PROP_PAD_ZORDER:
+      pad->zorder = g_value_get_uint (value);
+      break;
+    case PROP_PAD_ALPHA:
+      pad->alpha = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+
+  /* only the composition changes, the tile is not converted again */
+  parent = gst_object_get_parent (GST_OBJECT (pad));
+  if (parent) {
+    gst_gles_compositor_mark_dirty (GST_GLES_COMPOSITOR (parent));
+    gst_object_unref (parent);
+  }
+}
+
+static void
+gst_gles_compositor_pad_get_property (GObject *object, guint prop_id,
+                                      GValue *value, GParamSpec *pspec)
+{
+  GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      g_value_set_int (value, pad->xpos);
+      break;
+    case PROP_PAD_YPOS:
+      g_value_set_int (value, pad->ypos);
+      break;
+    case PROP_PAD_WIDTH:
+      g_value_set_int (value, pad->width);
+      break;
+    case PROP_PAD_HEIGHT:
+      g_value_set_int (value, pad->height);
+      break;
+    case PROP_PAD_ZORDER:
+      g_value_set_uint (value, pad->zorder);
+      break;
+    case PROP_PAD_ALPHA:
+      g_value_set_double (value, pad->alpha);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_gles_compositor_pad_finalize (GObject *object)
+{
+  GstGLESCompositorPad *pad = GST_GLES_COMPOSITOR_PAD (object);
+
+  if (pad->tile)
+    g_slice_free (GstGLESTile, pad->tile);
+  gst_buffer_replace (&pad->pending, NULL);
+
+  G_OBJECT_CLASS (gst_gles_compositor_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_gles_compositor_pad_class_init (GstGLESCompositorPadClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->set_property = gst_gles_compositor_pad_set_property;
+  gobject_class->get_property = gst_gles_compositor_pad_get_property;
+  gobject_class->finalize = gst_gles_compositor_pad_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_XPOS,
+      g_param_spec_int ("xpos", "X position", "Left edge of the tile in "
+        "the window.", G_MININT, G_MAXINT, 0,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_YPOS,
+      g_param_spec_int ("ypos", "Y position", "Top edge of the tile in "
+        "the window.", G_MININT, G_MAXINT, 0,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_WIDTH,
+      g_param_spec_int ("width", "Width", "Width of the tile, 0 uses the "
+        "video width.", 0, G_MAXINT, 0,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_HEIGHT,
+      g_param_spec_int ("height", "Height", "Height of the tile, 0 uses the "
+        "video height.", 0, G_MAXINT, 0,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_ZORDER,
+      g_param_spec_uint ("zorder", "Z-Order", "Tiles with a higher z-order "
+        "are drawn on top.", 0, G_MAXUINT, 0,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_ALPHA,
+      g_param_spec_double ("alpha", "Alpha", "Opacity of the tile.",
+        0.0, 1.0, DEFAULT_PAD_ALPHA,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_gles_compositor_pad_init (GstGLESCompositorPad *pad)
+{
+  pad->alpha = DEFAULT_PAD_ALPHA;
+  pad->tile = g_slice_new0 (GstGLESTile);
+  gst_segment_init (&pad->segment, GST_FORMAT_TIME);
+}
+
+/* Child proxy, so the pad properties can be set from gst-launch */
+
+static GObject *
+gst_gles_compositor_child_proxy_get_child_by_index (GstChildProxy *proxy,
+                                                    guint index)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (proxy);
+  GObject *obj;
+
+  GST_OBJECT_LOCK (comp);
+  obj = g_list_nth_data (GST_ELEMENT (comp)->sinkpads, index);
+  if (obj)
+    gst_object_ref (obj);
+  GST_OBJECT_UNLOCK (comp);
+
+  return obj;
+}
+
+static guint
+gst_gles_compositor_child_proxy_get_children_count (GstChildProxy *proxy)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (proxy);
+  guint count;
+
+  GST_OBJECT_LOCK (comp);
+  count = GST_ELEMENT (comp)->numsinkpads;
+  GST_OBJECT_UNLOCK (comp);
+
+  return count;
+}
+
+static void
+gst_gles_compositor_child_proxy_init (gpointer g_iface, gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  iface->get_child_by_index =
+      gst_gles_compositor_child_proxy_get_child_by_index;
+  iface->get_children_count =
+      gst_gles_compositor_child_proxy_get_children_count;
+}
+
+/* Element */
+
+static GstStateChangeReturn
+gst_gles_compositor_change_state (GstElement *element,
+                                  GstStateChange transition)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_gles_compositor_set_flushing (comp, FALSE);
+      if (!gst_gles_compositor_start (comp))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      gst_gles_compositor_set_playing (comp, TRUE);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      gst_gles_compositor_set_playing (comp, FALSE);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* unblock the streaming threads before the pads deactivate */
+      gst_gles_compositor_set_flushing (comp, TRUE);
+      g_mutex_lock (&comp->lock);
+      comp->running = FALSE;
+      g_cond_broadcast (&comp->cond);
+      g_mutex_unlock (&comp->lock);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_gles_compositor_parent_class)->change_state
+      (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_gles_compositor_stop (comp);
+
+  return ret;
+}
+
+#if GST_CHECK_VERSION(1, 2, 0)
+static void
+gst_gles_compositor_set_context (GstElement *element, GstContext *context)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (element);
+  GstGLESPool *pool = gst_gles_pool_from_context (context);
+
+  /* tiles are drawn into an X window */
+  if (pool && pool->backend->type != GST_GLES_BACKEND_X11) {
+    gst_gles_pool_unref (pool);
+    pool = NULL;
+  }
+
+  if (pool) {
+    GST_OBJECT_LOCK (comp);
+    if (comp->app_pool)
+      gst_gles_pool_unref (comp->app_pool);
+    comp->app_pool = pool;
+    GST_OBJECT_UNLOCK (comp);
+  }
+
+  if (GST_ELEMENT_CLASS (gst_gles_compositor_parent_class)->set_context)
+    GST_ELEMENT_CLASS (gst_gles_compositor_parent_class)->set_context
+        (element, context);
+}
+#endif
+
+static void
+gst_gles_compositor_set_property (GObject *object, guint prop_id,
+                                  const GValue *value, GParamSpec *pspec)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (object);
+
+  switch (prop_id) {
+    case PROP_WIDTH:
+      comp->width = g_value_get_int (value);
+      break;
+    case PROP_HEIGHT:
+      comp->height = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gles_compositor_get_property (GObject *object, guint prop_id,
+                                  GValue *value, GParamSpec *pspec)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (object);
+
+  switch (prop_id) {
+    case PROP_WIDTH:
+      g_value_set_int (value, comp->width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_int (value, comp->height);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gles_compositor_finalize (GObject *object)
+{
+  GstGLESCompositor *comp = GST_GLES_COMPOSITOR (object);
+
+  if (comp->app_pool)
+    gst_gles_pool_unref (comp->app_pool);
+  gst_gles_compositor_drop_dead_tiles (comp);
+  g_mutex_clear (&comp->lock);
+  g_cond_clear (&comp->cond);
+
+  G_OBJECT_CLASS (gst_gles_compositor_parent_class)->finalize (object);
+}
+
+static void
+gst_gles_compositor_class_init (GstGLESCompositorClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_gles_compositor_set_property;
+  gobject_class->get_property = gst_gles_compositor_get_property;
+  gobject_class->finalize = gst_gles_compositor_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_WIDTH,
+      g_param_spec_int ("width", "Width", "Width of the output window.",
+        1, G_MAXINT, DEFAULT_WIDTH, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_HEIGHT,
+      g_param_spec_int ("height", "Height", "Height of the output window.",
+        1, G_MAXINT, DEFAULT_HEIGHT, G_PARAM_READWRITE));
+
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_gles_compositor_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_gles_compositor_release_pad);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_gles_compositor_change_state);
+#if GST_CHECK_VERSION(1, 2, 0)
+  element_class->set_context =
+      GST_DEBUG_FUNCPTR (gst_gles_compositor_set_context);
+#endif
+
+  gst_element_class_set_details_simple (element_class,
+    "GLES compositor",
+    "Sink/Video",
+    "Composite video streams into one window using Open GL ES 2.0",
+    "Julian Scheel <julian jusst de>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gles_compositor_sink_factory));
+}
+
+static void
+gst_gles_compositor_init (GstGLESCompositor *comp)
+{
+  comp->width = DEFAULT_WIDTH;
+  comp->height = DEFAULT_HEIGHT;
+
+  g_mutex_init (&comp->lock);
+  g_cond_init (&comp->cond);
+
+  /* the bin waits for its eos like for any other sink */
+  GST_OBJECT_FLAG_SET (comp, GST_ELEMENT_FLAG_SINK);
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_GLES_COMPOSITOR_H__
+#define _GST_GLES_COMPOSITOR_H__
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+
+#include <X11/Xlib.h>
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "shader.h"
+#include "pool.h"
+#include "tile.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GLES_COMPOSITOR \
+  (gst_gles_compositor_get_type())
+#define GST_GLES_COMPOSITOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GLES_COMPOSITOR,GstGLESCompositor))
+#define GST_IS_GLES_COMPOSITOR(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GLES_COMPOSITOR))
+
+#define GST_TYPE_GLES_COMPOSITOR_PAD \
+  (gst_gles_compositor_pad_get_type())
+#define GST_GLES_COMPOSITOR_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GLES_COMPOSITOR_PAD,GstGLESCompositorPad))
+
+typedef struct _GstGLESCompositor          GstGLESCompositor;
+typedef struct _GstGLESCompositorClass     GstGLESCompositorClass;
+typedef struct _GstGLESCompositorPad       GstGLESCompositorPad;
+typedef struct _GstGLESCompositorPadClass  GstGLESCompositorPadClass;
+
+struct _GstGLESCompositorPad
+{
+  GstPad pad;
+
+  /* properties, protected by the object lock */
+  gint xpos;
+  gint ypos;
+  gint width;
+  gint height;
+  guint zorder;
+  gdouble alpha;
+
+  /* streaming thread state */
+  GstVideoInfo info;
+  gboolean have_info;
+  GstSegment segment;
+  gboolean eos;
+
+  /* protected by the object lock */
+  GstClockID clock_id;
+  gboolean flushing;
+
+  /* latest frame not converted yet, protected by the compositor lock */
+  GstBuffer *pending;
+  GstVideoInfo pending_info;
+
+  /* gl objects of the input, only touched by the gl thread */
+  GstGLESTile *tile;
+};
+
+struct _GstGLESCompositorPadClass
+{
+  GstPadClass parent_class;
+};
+
+struct _GstGLESCompositor
+{
+  GstElement element;
+
+  /* properties */
+  gint width;
+  gint height;
+
+  guint next_pad_id;
+
+  /* set by the application through a GstContext */
+  GstGLESPool *app_pool;
+
+  /* gl thread, the lock protects the flags, the pending buffers and
+   * the tiles of released pads. Paused streaming threads wait on the
+   * cond as well, so it is always broadcast */
+  GThread *thread;
+  GMutex lock;
+  GCond cond;
+  gboolean init_done;
+  gboolean running;
+  gboolean playing;
+  gboolean dirty;
+  GList *dead_tiles;
+
+  /* gl thread only */
+  GstGLESPool *pool;
+  Window window;
+  gint window_width;
+  gint window_height;
+  EGLSurface surface;
+  EGLContext context;
+  gboolean shared;
+  GstGLESShader convert;
+  GstGLESShader copy;
+  GLint copy_tex_loc;
+  GLuint quad_vbo;
+  GLuint quad_ibo;
+};
+
+struct _GstGLESCompositorClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_gles_compositor_get_type (void);
+GType gst_gles_compositor_pad_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GLES_COMPOSITOR_H__ */
@@ -0,0 +1,680 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-glesconvert
+ *
+ * Converts I420 to RGBA and deinterlaces it on the GPU, without a window.
+ * The result is read back through pixel buffers one frame behind the
+ * upload, so reading a frame never waits for the frame just submitted.
+ * The output is delayed by one frame for this, which is reported as
+ * latency. Without OpenGL ES 3.0 the frame is read back synchronously.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 videotestsrc ! glesconvert ! videoconvert ! x264enc ! \
+ *     matroskamux ! filesink location=out.mkv
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstglesconvert.h"
+
+#if GST_CHECK_VERSION(1, 0, 0)
+
+/* FIXME: Should be part of the GLES headers */
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER                                    0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ                                          0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT                                         0x0001
+#endif
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+#define DEFAULT_DEINTERLACE TRUE
+
+enum
+{
+  PROP_0,
+  PROP_DEINTERLACE
+};
+
+static GstStaticPadTemplate gles_convert_sink_factory =
+    GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("I420"))
+    );
+
+static GstStaticPadTemplate gles_convert_src_factory =
+    GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("RGBA"))
+    );
+
+G_DEFINE_TYPE (GstGLESConvert, gst_gles_convert, GST_TYPE_BASE_TRANSFORM);
+
+/* Context */
+
+static gint
+egl_convert_open (GstGLESConvert *convert)
+{
+    const EGLint config_attribs[] =
+    {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+    const EGLint surface_attribs[] =
+    {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    const EGLint context_attribs[] =
+    {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    EGLDisplay display = convert->pool->display;
+    EGLint num_configs;
+
+    if (!eglChooseConfig (display, config_attribs, &convert->config, 1,
+                          &num_configs) || num_configs < 1) {
+        GST_ERROR_OBJECT (convert, "No EGL config for pixel buffers");
+        return -1;
+    }
+
+    /* everything is drawn into framebuffer objects, the surface only
+     * exists to make the context current */
+    convert->surface = eglCreatePbufferSurface (display, convert->config,
+                                                surface_attribs);
+    if (convert->surface == EGL_NO_SURFACE) {
+        GST_ERROR_OBJECT (convert, "Could not create EGL pbuffer surface");
+        return -1;
+    }
+
+    convert->shared = convert->pool->context != NULL;
+    convert->context = eglCreateContext (display, convert->config,
+                                         convert->shared ?
+                                         convert->pool->context :
+                                         EGL_NO_CONTEXT, context_attribs);
+    if (convert->context == EGL_NO_CONTEXT && convert->shared) {
+        /* the pool was set up for windows, this config may not share */
+        GST_DEBUG_OBJECT (convert, "Could not share context, use own");
+        convert->shared = FALSE;
+        convert->context = eglCreateContext (display, convert->config,
+                                             EGL_NO_CONTEXT,
+                                             context_attribs);
+    }
+    if (convert->context == EGL_NO_CONTEXT) {
+        GST_ERROR_OBJECT (convert, "Could not create EGL context");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* sets up the gl objects, called with the context current */
+static gint
+gl_convert_init (GstGLESConvert *convert)
+{
+    const gchar *version = (const gchar *) glGetString (GL_VERSION);
+    GstGLESShader *shaders[] = { &convert->convert, &convert->deint };
+    guint i;
+
+    if (gl_init_shader (GST_ELEMENT (convert), &convert->convert,
+                        SHADER_YUV_RGB) < 0 ||
+        gl_init_shader (GST_ELEMENT (convert), &convert->deint,
+                        SHADER_DEINT_LINEAR) < 0)
+        return -1;
+
+    for (i = 0; i < G_N_ELEMENTS (shaders); i++) {
+        GLint program = shaders[i]->program;
+
+        glUseProgram (program);
+        glUniform1i (glGetUniformLocation (program, "s_ytex"), 0);
+        glUniform1i (glGetUniformLocation (program, "s_utex"), 1);
+        glUniform1i (glGetUniformLocation (program, "s_vtex"), 2);
+    }
+    convert->line_height_loc =
+            glGetUniformLocation (convert->deint.program, "line_height");
+
+    if (convert->shared)
+        gst_gles_pool_get_quad (convert->pool, &convert->quad_vbo,
+                                &convert->quad_ibo);
+    else
+        gl_create_quad (&convert->quad_vbo, &convert->quad_ibo);
+
+    /* pixel pack buffers and mapping them are core in 3.0 */
+    if (version && g_str_has_prefix (version, "OpenGL ES 3")) {
+        convert->map_buffer_range = (GstGLESMapBufferRange)
+                eglGetProcAddress ("glMapBufferRange");
+        convert->unmap_buffer = (GstGLESUnmapBuffer)
+                eglGetProcAddress ("glUnmapBuffer");
+    }
+    convert->async = convert->map_buffer_range && convert->unmap_buffer;
+    if (convert->async)
+        glGenBuffers (GST_GLES_CONVERT_READBACKS, convert->pbo);
+    else
+        GST_INFO_OBJECT (convert, "No pixel buffers, read back "
+                         "synchronously");
+
+    convert->gl_ready = TRUE;
+
+    return 0;
+}
+
+static void
+gl_convert_close (GstGLESConvert *convert)
+{
+    if (convert->async)
+        glDeleteBuffers (GST_GLES_CONVERT_READBACKS, convert->pbo);
+    memset (convert->pbo, 0, sizeof (convert->pbo));
+    convert->async = FALSE;
+
+    gl_tile_free (&convert->tile);
+    if (!convert->shared && convert->quad_vbo) {
+        glDeleteBuffers (1, &convert->quad_vbo);
+        glDeleteBuffers (1, &convert->quad_ibo);
+    }
+    convert->quad_vbo = 0;
+    convert->quad_ibo = 0;
+
+    gl_delete_shader (&convert->convert);
+    gl_delete_shader (&convert->deint);
+    convert->gl_ready = FALSE;
+}
+
+static gboolean
+egl_convert_make_current (GstGLESConvert *convert)
+{
+    if (!eglMakeCurrent (convert->pool->display, convert->surface,
+                         convert->surface, convert->context)) {
+        GST_ERROR_OBJECT (convert, "Could not set EGL context to current");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* the streaming thread and the state changes use the context, so it is
+ * only current while one of them needs it */
+static void
+egl_convert_release (GstGLESConvert *convert)
+{
+    eglMakeCurrent (convert->pool->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                    EGL_NO_CONTEXT);
+}
+
+/* Readback */
+
+/* copies a frame read back from the framebuffer into the output, the
+ * rows come bottom up */
+static void
+gst_gles_convert_copy_out (GstGLESConvert *convert, const guint8 *pixels,
+                           GstBuffer *outbuf)
+{
+    GstVideoFrame frame;
+    gint width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
+    gint height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
+    guint8 *data;
+    gint stride;
+    gint i;
+
+    if (!gst_video_frame_map (&frame, &convert->out_info, outbuf,
+                              GST_MAP_WRITE)) {
+        GST_WARNING_OBJECT (convert, "Failed to map output buffer");
+        return;
+    }
+
+    data = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+    stride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+    for (i = 0; i < height; i++)
+        memcpy (data + i * stride, pixels + (height - 1 - i) * width * 4,
+                width * 4);
+
+    gst_video_frame_unmap (&frame);
+}
+
+/* starts reading the framebuffer into the next pixel buffer */
+static void
+gl_convert_start_readback (GstGLESConvert *convert)
+{
+    gint width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
+    gint height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
+
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, convert->pbo[convert->next]);
+    glBufferData (GL_PIXEL_PACK_BUFFER, width * height * 4, NULL,
+                  GL_STREAM_READ);
+    glPixelStorei (GL_PACK_ALIGNMENT, 4);
+    glReadPixels (0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+    convert->next = (convert->next + 1) % GST_GLES_CONVERT_READBACKS;
+}
+
+/* copies the readback started for the previous frame into outbuf. The
+ * copy for the current frame was queued after it, so the map only waits
+ * for a frame that had a whole frame interval to finish */
+static gboolean
+gl_convert_finish_readback (GstGLESConvert *convert, GstBuffer *outbuf)
+{
+    gint width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
+    gint height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
+    guint slot = (convert->next + GST_GLES_CONVERT_READBACKS - 2) %
+            GST_GLES_CONVERT_READBACKS;
+    const guint8 *pixels;
+
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, convert->pbo[slot]);
+    pixels = convert->map_buffer_range (GL_PIXEL_PACK_BUFFER, 0,
+                                        width * height * 4,
+                                        GL_MAP_READ_BIT);
+    if (pixels) {
+        gst_gles_convert_copy_out (convert, pixels, outbuf);
+        convert->unmap_buffer (GL_PIXEL_PACK_BUFFER);
+    } else {
+        GST_WARNING_OBJECT (convert, "Could not map pixel buffer");
+    }
+    glBindBuffer (GL_PIXEL_PACK_BUFFER, 0);
+
+    return pixels != NULL;
+}
+
+static void
+gl_convert_read_sync (GstGLESConvert *convert, GstBuffer *outbuf)
+{
+    gint width = GST_VIDEO_INFO_WIDTH (&convert->out_info);
+    gint height = GST_VIDEO_INFO_HEIGHT (&convert->out_info);
+
+    if (!convert->scratch)
+        convert->scratch = g_malloc (width * height * 4);
+
+    glPixelStorei (GL_PACK_ALIGNMENT, 4);
+    glReadPixels (0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                  convert->scratch);
+    gst_gles_convert_copy_out (convert, convert->scratch, outbuf);
+}
+
+/* takes over the timing of the frame in flight */
+static void
+gst_gles_convert_take_in_flight (GstGLESConvert *convert,
+                                 GstBuffer *outbuf)
+{
+    GST_BUFFER_PTS (outbuf) = GST_BUFFER_PTS (convert->in_flight);
+    GST_BUFFER_DTS (outbuf) = GST_BUFFER_DTS (convert->in_flight);
+    GST_BUFFER_DURATION (outbuf) = GST_BUFFER_DURATION (convert->in_flight);
+    GST_BUFFER_OFFSET (outbuf) = GST_BUFFER_OFFSET (convert->in_flight);
+    GST_BUFFER_OFFSET_END (outbuf) =
+            GST_BUFFER_OFFSET_END (convert->in_flight);
+    GST_BUFFER_FLAGS (outbuf) = GST_BUFFER_FLAGS (convert->in_flight);
+
+    gst_buffer_replace (&convert->in_flight, NULL);
+}
+
+/* pushes the frame still in flight, at eos */
+static void
+gst_gles_convert_drain (GstGLESConvert *convert)
+{
+    GstBaseTransform *trans = GST_BASE_TRANSFORM (convert);
+    GstBuffer *outbuf;
+    gboolean read;
+
+    if (!convert->in_flight)
+        return;
+
+    outbuf = gst_buffer_new_allocate (NULL,
+                                      GST_VIDEO_INFO_SIZE (&convert->out_info),
+                                      NULL);
+    if (!egl_convert_make_current (convert)) {
+        gst_buffer_unref (outbuf);
+        gst_buffer_replace (&convert->in_flight, NULL);
+        return;
+    }
+    /* nothing was queued after the last frame */
+    convert->next = (convert->next + 1) % GST_GLES_CONVERT_READBACKS;
+    read = gl_convert_finish_readback (convert, outbuf);
+    egl_convert_release (convert);
+
+    gst_gles_convert_take_in_flight (convert, outbuf);
+    if (read)
+        gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (trans), outbuf);
+    else
+        gst_buffer_unref (outbuf);
+}
+
+/* Transform */
+
+static GstFlowReturn
+gst_gles_convert_transform (GstBaseTransform *trans, GstBuffer *inbuf,
+                            GstBuffer *outbuf)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+    GstGLESShader *shader = &convert->convert;
+    GstFlowReturn ret = GST_FLOW_OK;
+    GstVideoFrame frame;
+    GstBuffer *timing;
+
+    if (!egl_convert_make_current (convert))
+        return GST_FLOW_ERROR;
+
+    if (!convert->gl_ready && gl_convert_init (convert) < 0) {
+        egl_convert_release (convert);
+        GST_ELEMENT_ERROR (convert, LIBRARY, INIT,
+                           ("Could not initialize GL context"), (NULL));
+        return GST_FLOW_ERROR;
+    }
+
+    if (!gst_video_frame_map (&frame, &convert->in_info, inbuf,
+                              GST_MAP_READ)) {
+        egl_convert_release (convert);
+        GST_WARNING_OBJECT (convert, "Failed to map buffer data");
+        return GST_FLOW_ERROR;
+    }
+    gl_tile_upload (&convert->tile, &frame);
+    gst_video_frame_unmap (&frame);
+
+    if (convert->deinterlace &&
+        GST_VIDEO_INFO_IS_INTERLACED (&convert->in_info)) {
+        shader = &convert->deint;
+        glUseProgram (shader->program);
+        glUniform1f (convert->line_height_loc,
+                     1.0 / GST_VIDEO_INFO_HEIGHT (&convert->in_info));
+    }
+    gl_tile_render (&convert->tile, shader, convert->quad_vbo,
+                    convert->quad_ibo);
+
+    if (!convert->async) {
+        gl_convert_read_sync (convert, outbuf);
+        egl_convert_release (convert);
+        return GST_FLOW_OK;
+    }
+
+    /* queue this frame before waiting for the previous one */
+    gl_convert_start_readback (convert);
+
+    timing = gst_buffer_new ();
+    gst_buffer_copy_into (timing, inbuf, GST_BUFFER_COPY_FLAGS |
+                          GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+    if (convert->in_flight) {
+        if (!gl_convert_finish_readback (convert, outbuf))
+            ret = GST_FLOW_ERROR;
+        gst_gles_convert_take_in_flight (convert, outbuf);
+    } else {
+        ret = GST_BASE_TRANSFORM_FLOW_DROPPED;
+    }
+    convert->in_flight = timing;
+
+    egl_convert_release (convert);
+
+    return ret;
+}
+
+static GstCaps *
+gst_gles_convert_transform_caps (GstBaseTransform *trans,
+                                 GstPadDirection direction, GstCaps *caps,
+                                 GstCaps *filter)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+    GstCaps *res = gst_caps_new_empty ();
+    guint i;
+
+    for (i = 0; i < gst_caps_get_size (caps); i++) {
+        GstStructure *s = gst_structure_copy (gst_caps_get_structure (caps,
+                                                                      i));
+
+        gst_structure_set (s, "format", G_TYPE_STRING,
+                           direction == GST_PAD_SINK ? "RGBA" : "I420",
+                           NULL);
+        gst_structure_remove_fields (s, "colorimetry", "chroma-site", NULL);
+        /* deinterlaced output is progressive, any input mode works */
+        if (convert->deinterlace)
+            gst_structure_remove_fields (s, "interlace-mode",
+                                         "field-order", NULL);
+        res = gst_caps_merge_structure (res, s);
+    }
+
+    if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, res,
+                                                GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (res);
+        res = tmp;
+    }
+
+    return res;
+}
+
+static gboolean
+gst_gles_convert_set_caps (GstBaseTransform *trans, GstCaps *incaps,
+                           GstCaps *outcaps)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+
+    if (!gst_video_info_from_caps (&convert->in_info, incaps) ||
+        !gst_video_info_from_caps (&convert->out_info, outcaps))
+        return FALSE;
+
+    /* a frame in flight has the old size */
+    gst_buffer_replace (&convert->in_flight, NULL);
+    g_free (convert->scratch);
+    convert->scratch = NULL;
+
+    return TRUE;
+}
+
+static gboolean
+gst_gles_convert_sink_event (GstBaseTransform *trans, GstEvent *event)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+
+    switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+        gst_gles_convert_drain (convert);
+        break;
+    case GST_EVENT_FLUSH_STOP:
+        gst_buffer_replace (&convert->in_flight, NULL);
+        break;
+    default:
+        break;
+    }
+
+    return GST_BASE_TRANSFORM_CLASS (gst_gles_convert_parent_class)->
+            sink_event (trans, event);
+}
+
+static gboolean
+gst_gles_convert_query (GstBaseTransform *trans, GstPadDirection direction,
+                        GstQuery *query)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+    gboolean ret;
+
+    ret = GST_BASE_TRANSFORM_CLASS (gst_gles_convert_parent_class)->
+            query (trans, direction, query);
+
+    /* the readback holds one frame back */
+    if (ret && direction == GST_PAD_SRC &&
+        GST_QUERY_TYPE (query) == GST_QUERY_LATENCY && convert->async &&
+        GST_VIDEO_INFO_FPS_N (&convert->in_info) > 0) {
+        GstClockTime min, max;
+        GstClockTime frame;
+        gboolean live;
+
+        frame = gst_util_uint64_scale_int (GST_SECOND,
+                GST_VIDEO_INFO_FPS_D (&convert->in_info),
+                GST_VIDEO_INFO_FPS_N (&convert->in_info));
+        gst_query_parse_latency (query, &live, &min, &max);
+        min += frame;
+        if (GST_CLOCK_TIME_IS_VALID (max))
+            max += frame;
+        gst_query_set_latency (query, live, min, max);
+    }
+
+    return ret;
+}
+
+static gboolean
+gst_gles_convert_start (GstBaseTransform *trans)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+    gboolean created;
+
+    /* no window is needed, so no X server either */
+    convert->pool = gst_gles_pool_get_default (GST_GLES_BACKEND_PBUFFER,
+                                               &created);
+    if (!convert->pool) {
+        GST_ELEMENT_ERROR (convert, RESOURCE, OPEN_READ_WRITE,
+                           ("Could not open display"), (NULL));
+        return FALSE;
+    }
+
+    if (egl_convert_open (convert) < 0) {
+        GST_ELEMENT_ERROR (convert, LIBRARY, INIT,
+                           ("Could not initialize GL context"), (NULL));
+        return FALSE;
+    }
+
+    convert->next = 0;
+
+    return TRUE;
+}
+
+static gboolean
+gst_gles_convert_stop (GstBaseTransform *trans)
+{
+    GstGLESConvert *convert = GST_GLES_CONVERT (trans);
+
+    gst_buffer_replace (&convert->in_flight, NULL);
+    g_free (convert->scratch);
+    convert->scratch = NULL;
+
+    if (!convert->pool)
+        return TRUE;
+
+    if (convert->context) {
+        if (convert->gl_ready && egl_convert_make_current (convert)) {
+            gl_convert_close (convert);
+            egl_convert_release (convert);
+        }
+        eglDestroyContext (convert->pool->display, convert->context);
+        convert->context = NULL;
+    }
+    if (convert->surface) {
+        eglDestroySurface (convert->pool->display, convert->surface);
+        convert->surface = NULL;
+    }
+
+    gst_gles_pool_unref (convert->pool);
+    convert->pool = NULL;
+
+    return TRUE;
+}
+
+static void
+gst_gles_convert_set_property (GObject *object, guint prop_id,
+                               const GValue *value, GParamSpec *pspec)
+{
+  GstGLESConvert *convert = GST_GLES_CONVERT (object);
+
+  switch (prop_id) {
+    case PROP_DEINTERLACE:
+      convert->deinterlace = g_value_get_boolean (value);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (convert));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gles_convert_get_property (GObject *object, guint prop_id,
+                               GValue *value, GParamSpec *pspec)
+{
+  GstGLESConvert *convert = GST_GLES_CONVERT (object);
+
+  switch (prop_id) {
+    case PROP_DEINTERLACE:
+      g_value_set_boolean (value, convert->deinterlace);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gles_convert_class_init (GstGLESConvertClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+  gobject_class->set_property = gst_gles_convert_set_property;
+  gobject_class->get_property = gst_gles_convert_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_DEINTERLACE,
+      g_param_spec_boolean ("deinterlace", "Deinterlace",
+        "Deinterlace interlaced input, the output is progressive.",
+        DEFAULT_DEINTERLACE, G_PARAM_READWRITE));
+
+  trans_class->start = GST_DEBUG_FUNCPTR (gst_gles_convert_start);
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_gles_convert_stop);
+  trans_class->transform_caps =
+      GST_DEBUG_FUNCPTR (gst_gles_convert_transform_caps);
+  trans_class->set_caps = GST_DEBUG_FUNCPTR (gst_gles_convert_set_caps);
+  trans_class->transform = GST_DEBUG_FUNCPTR (gst_gles_convert_transform);
+  trans_class->sink_event = GST_DEBUG_FUNCPTR (gst_gles_convert_sink_event);
+  trans_class->query = GST_DEBUG_FUNCPTR (gst_gles_convert_query);
+
+  gst_element_class_set_details_simple (element_class,
+    "GLES convert",
+    "Filter/Converter/Video",
+    "Convert and deinterlace video using Open GL ES 2.0",
+    "Julian Scheel <julian jusst de>");
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gles_convert_sink_factory));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&gles_convert_src_factory));
+}
+
+static void
+gst_gles_convert_init (GstGLESConvert *convert)
+{
+  convert->deinterlace = DEFAULT_DEINTERLACE;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _GST_GLES_CONVERT_H__
+#define _GST_GLES_CONVERT_H__
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+#include <gst/video/video.h>
+
+#include "shader.h"
+#include "pool.h"
+#include "tile.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_GLES_CONVERT \
+  (gst_gles_convert_get_type())
+#define GST_GLES_CONVERT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_GLES_CONVERT,GstGLESConvert))
+#define GST_IS_GLES_CONVERT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_GLES_CONVERT))
+
+/* frames read back at the same time */
+#define GST_GLES_CONVERT_READBACKS 2
+
+typedef struct _GstGLESConvert       GstGLESConvert;
+typedef struct _GstGLESConvertClass  GstGLESConvertClass;
+
+typedef void *(GL_APIENTRY *GstGLESMapBufferRange) (GLenum target,
+                                                    GLintptr offset,
+                                                    GLsizeiptr length,
+                                                    GLbitfield access);
+typedef GLboolean (GL_APIENTRY *GstGLESUnmapBuffer) (GLenum target);
+
+struct _GstGLESConvert
+{
+  GstBaseTransform element;
+
+  /* properties */
+  gboolean deinterlace;
+
+  GstVideoInfo in_info;
+  GstVideoInfo out_info;
+
+  /* headless context, current only while a frame is converted */
+  GstGLESPool *pool;
+  EGLConfig config;
+  EGLSurface surface;
+  EGLContext context;
+  gboolean shared;
+  gboolean gl_ready;
+
+  GstGLESShader convert;
+  GstGLESShader deint;
+  GLint line_height_loc;
+  GLuint quad_vbo;
+  GLuint quad_ibo;
+  GstGLESTile tile;
+
+  /* readback into pixel buffers, one frame behind the upload. Without
+   * pixel buffers the frame is read back synchronously */
+  gboolean async;
+  GstGLESMapBufferRange map_buffer_range;
+  GstGLESUnmapBuffer unmap_buffer;
+  GLuint pbo[GST_GLES_CONVERT_READBACKS];
+  guint next;
+  /* timing of the frame whose readback is in flight, NULL if none */
+  GstBuffer *in_flight;
+  guint8 *scratch;
+};
+
+struct _GstGLESConvertClass
+{
+  GstBaseTransformClass parent_class;
+};
+
+GType gst_gles_convert_get_type (void);
+
+G_END_DECLS
+
+#endif /* _GST_GLES_CONVERT_H__ */
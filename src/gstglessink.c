@@ -54,6 +54,7 @@
 #include <gst/video/video.h>
 
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 
@@ -62,10 +63,69 @@
 #include <unistd.h>
 
 #include "gstglessink.h"
+#include "gstglescompositor.h"
+#include "gstglesconvert.h"
 #include "shader.h"
+#include "timer.h"
+#include "stats.h"
+#include "trace.h"
+#include "pool.h"
 
 GST_DEBUG_CATEGORY (gst_gles_sink_debug);
 
+/* FIXME: Should be part of the EGL headers */
+#ifndef EGL_BUFFER_AGE_EXT
+#define EGL_BUFFER_AGE_EXT                                      0x313D
+#endif
+
+#define DEFAULT_SWAP_INTERVAL 1
+#define DEFAULT_CONTEXT_TIMEOUT 0
+#define DEFAULT_BACKEND GST_GLES_BACKEND_X11
+#define DEFAULT_SCALING GST_GLES_SCALING_BILINEAR
+
+#define DEFAULT_WINDOW_WIDTH 720
+#define DEFAULT_WINDOW_HEIGHT 576
+
+#define DEFAULT_REFRESH_PERIOD (GST_SECOND / 60)
+
+/* swap intervals further apart are not used to estimate the refresh */
+#define PACING_MAX_VBLANKS 8
+
+/* smallest render delay change a latency message is posted for */
+#define LATENCY_THRESHOLD GST_MSECOND
+
+/* used as max-lateness until the frame budget is known */
+#define DEFAULT_MAX_LATENESS (20 * GST_MSECOND)
+
+/* adaptive quality: render cost relative to the frame budget above
+ * which a frame counts as overloaded, below which as having headroom */
+#define QUALITY_OVERLOAD_PERCENT 85
+#define QUALITY_HEADROOM_PERCENT 50
+/* consecutive frames needed to step down and, initially, up again */
+#define QUALITY_DOWNGRADE_FRAMES 5
+#define QUALITY_UPGRADE_FRAMES 60
+#define QUALITY_MAX_UPGRADE_FRAMES 1800
+
+static const gchar *quality_names[] = {
+    "full",             /* GST_GLES_QUALITY_FULL */
+    "bilinear",         /* GST_GLES_QUALITY_BILINEAR */
+    "no-deinterlace",   /* GST_GLES_QUALITY_NO_DEINTERLACE */
+    "half-fbo"          /* GST_GLES_QUALITY_HALF_FBO */
+};
+
+static const gchar *startup_names[] = {
+    "x11-open",         /* GST_GLES_STARTUP_X11_OPEN */
+    "x11-window",       /* GST_GLES_STARTUP_X11_WINDOW */
+    "egl-initialize",   /* GST_GLES_STARTUP_EGL_INITIALIZE */
+    "egl-config",       /* GST_GLES_STARTUP_EGL_CONFIG */
+    "egl-surface",      /* GST_GLES_STARTUP_EGL_SURFACE */
+    "egl-context",      /* GST_GLES_STARTUP_EGL_CONTEXT */
+    "shader-read",      /* GST_GLES_STARTUP_SHADER_READ */
+    "shader-compile",   /* GST_GLES_STARTUP_SHADER_COMPILE */
+    "framebuffer",      /* GST_GLES_STARTUP_FRAMEBUFFER */
+    "first-frame"       /* GST_GLES_STARTUP_FIRST_FRAME */
+};
+
 
 typedef enum _GstGLESPluginProperties  GstGLESPluginProperties;
 
@@ -77,7 +137,26 @@ enum _GstGLESPluginProperties
   PROP_CROP_BOTTOM,
   PROP_CROP_LEFT,
   PROP_CROP_RIGHT,
-  PROP_DROP_FIRST
+  PROP_DROP_FIRST,
+  PROP_SWAP_INTERVAL,
+  PROP_LOW_LATENCY,
+  PROP_SWAP_MODE,
+  PROP_PACING,
+  PROP_ADAPTIVE_QUALITY,
+  PROP_QUALITY,
+  PROP_REPORT_TIMINGS,
+  PROP_STATS,
+  PROP_STATS_INTERVAL,
+  PROP_TRACE_FILE,
+  PROP_CONTEXT_TIMEOUT,
+  PROP_BACKEND,
+  PROP_DEINTERLACE,
+  PROP_WINDOW_WIDTH,
+  PROP_WINDOW_HEIGHT,
+  PROP_READBACK,
+  PROP_MAX_TEXTURE_SIZE,
+  PROP_SCALING,
+  PROP_PACKED_UPLOAD
 };
 
 #if GST_CHECK_VERSION(1, 0, 0)
@@ -105,18 +184,29 @@ static GstFlowReturn gst_gles_sink_render (GstBaseSink * basesink,
                                              GstBuffer * buf);
 static GstFlowReturn gst_gles_sink_preroll (GstBaseSink * basesink,
                                               GstBuffer * buf);
+static gboolean gst_gles_sink_unlock (GstBaseSink * basesink);
+static gboolean gst_gles_sink_unlock_stop (GstBaseSink * basesink);
+#if GST_CHECK_VERSION(1, 2, 0)
+static gboolean gst_gles_sink_query (GstBaseSink * basesink,
+    GstQuery * query);
+static void gst_gles_sink_set_context (GstElement * element,
+    GstContext * context);
+#endif
 static void gst_gles_sink_finalize (GObject *gobject);
 static gint setup_gl_context (GstGLESSink *sink);
 static gpointer gl_thread_proc (gpointer data);
 
-#define WxH ", width = (int) [ 16, 4096 ], height = (int) [ 16, 4096 ]"
+/* frames larger than the GL textures are split into a grid of them */
+#define WxH ", width = (int) [ 16, 16384 ], height = (int) [ 16, 16384 ]"
 
 #if GST_CHECK_VERSION(1, 0, 0)
 static GstStaticPadTemplate gles_sink_factory =
         GST_STATIC_PAD_TEMPLATE ("sink",
                                  GST_PAD_SINK,
                                  GST_PAD_ALWAYS,
-                                 GST_STATIC_CAPS ( GST_VIDEO_CAPS_MAKE("I420")
+                                 GST_STATIC_CAPS ( GST_VIDEO_CAPS_MAKE(
+                                                   "{ I420, I420_10LE, "
+                                                   "P010_10LE }")
                                                    WxH) );
 #else
 static GstStaticPadTemplate gles_sink_factory =
@@ -128,6 +218,35 @@ static GstStaticPadTemplate gles_sink_factory =
 #endif
 
 /* OpenGL ES 2.0 implementation */
+/* Startup instrumentation: adds the time since *since to a phase and
+ * restarts the measurement */
+static void
+gl_startup_mark (GstGLESSink *sink, GstGLESStartupPhase phase,
+                 GstClockTime *since)
+{
+    GstClockTime now = gst_util_get_timestamp ();
+
+    sink->gl_thread.startup[phase] += now - *since;
+    *since = now;
+}
+
+static GstStructure *
+gst_gles_sink_get_startup (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstStructure *s;
+    guint i;
+
+    s = gst_structure_new ("GstGLESSinkStartup",
+                           "total", G_TYPE_UINT64, thread->startup_total,
+                           NULL);
+    for (i = 0; i < GST_GLES_STARTUP_PHASES; i++)
+        gst_structure_set (s, startup_names[i], G_TYPE_UINT64,
+                           thread->startup[i], NULL);
+
+    return s;
+}
+
 static GLuint
 gl_create_texture(GLuint tex_filter)
 {
@@ -145,6 +264,116 @@ gl_create_texture(GLuint tex_filter)
     return tex_id;
 }
 
+/* the yuv planes are always bound to the same texture units, so the
+ * samplers only have to be set up once per program */
+static void
+gl_init_yuv_samplers (GstGLESShader *shader)
+{
+    glUseProgram (shader->program);
+    glUniform1i (glGetUniformLocation (shader->program, "s_ytex"), 0);
+    glUniform1i (glGetUniformLocation (shader->program, "s_utex"), 1);
+    glUniform1i (glGetUniformLocation (shader->program, "s_vtex"), 2);
+    glUniform1i (glGetUniformLocation (shader->program, "s_lut"), 4);
+}
+
+/* rebuilds the yuv programs when the planes of the new frame layout or
+ * its colorimetry need other conversion code than the programs were
+ * built with. The tone mapping table lives on texture unit 4 */
+static void
+gl_update_yuv_shaders (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    GstGLESShader *shaders[] = { &gles->deinterlace, &gles->convert };
+    const GstGLESShaderTypes types[] = {
+        SHADER_DEINT_LINEAR,
+        SHADER_YUV_RGB
+    };
+    const gchar *layout = gl_grid_shader_defines (&gles->grid);
+    const gchar *color = gst_gles_color_shader_defines (&sink->color);
+    gint ret[G_N_ELEMENTS (shaders)];
+    gchar *defines = NULL;
+    guint i;
+
+    if (sink->color.tone_map != TONE_MAP_NONE &&
+        memcmp (&sink->color, &gles->color, sizeof (GstGLESColor)) != 0) {
+        glActiveTexture (GL_TEXTURE4);
+        gl_tone_map_upload (&sink->color, &gles->lut_tex);
+    }
+    gles->color = sink->color;
+
+    if (layout || color)
+        defines = g_strconcat (layout ? layout : "", color ? color : "",
+                               NULL);
+
+    if (g_strcmp0 (defines, gles->yuv_defines) == 0) {
+        g_free (defines);
+        gl_state_invalidate (&gles->state);
+        return;
+    }
+
+    GST_DEBUG_OBJECT (sink, "Rebuild yuv programs with %s",
+                      defines ? defines : "no defines");
+
+    for (i = 0; i < G_N_ELEMENTS (shaders); i++) {
+        gl_delete_shader (shaders[i]);
+        ret[i] = gl_begin_shader_variant (GST_ELEMENT (sink), shaders[i],
+                                          types[i], defines);
+    }
+    for (i = 0; i < G_N_ELEMENTS (shaders); i++) {
+        if (ret[i] == 0)
+            ret[i] = gl_finish_shader (GST_ELEMENT (sink), shaders[i]);
+
+        if (ret[i] < 0)
+            GST_ERROR_OBJECT (sink, "Could not build yuv program: %d",
+                              ret[i]);
+        else
+            gl_init_yuv_samplers (shaders[i]);
+    }
+
+    g_free (gles->yuv_defines);
+    gles->yuv_defines = defines;
+
+    gles->line_height_loc = glGetUniformLocation (gles->deinterlace.program,
+                                                  "line_height");
+    gl_state_invalidate (&gles->state);
+}
+
+/* (re)allocates the plane textures and the fbo texture for the
+ * negotiated size, the texture and framebuffer objects are kept */
+static void
+gl_alloc_frame_textures (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    gint width = GST_VIDEO_SINK_WIDTH (sink);
+    gint height = GST_VIDEO_SINK_HEIGHT (sink);
+    gint max_size = gles->max_texture_size;
+
+    gl_grid_alloc (&gles->grid, width, height, max_size, sink->grid_format);
+    gl_update_yuv_shaders (sink);
+
+    /* a frame larger than a texture is scaled down in the fbo pass, no
+     * window shows it at full size anyway */
+    gles->fbo_width = width;
+    gles->fbo_height = height;
+    if (width > max_size || height > max_size) {
+        gdouble scale = MIN ((gdouble) max_size / width,
+                             (gdouble) max_size / height);
+
+        gles->fbo_width = MIN (max_size, (gint) (width * scale + 0.5));
+        gles->fbo_height = MIN (max_size, (gint) (height * scale + 0.5));
+        GST_INFO_OBJECT (sink, "Frame of %dx%d converted at %dx%d",
+                         width, height, gles->fbo_width, gles->fbo_height);
+    }
+
+    glBindTexture (GL_TEXTURE_2D, gles->rgb_tex.id);
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB, gles->fbo_width,
+                  gles->fbo_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    gl_state_invalidate (&gles->state);
+
+    gles->frame_width = width;
+    gles->frame_height = height;
+}
+
 static void
 gl_gen_framebuffer(GstGLESSink *sink)
 {
@@ -155,21 +384,20 @@ gl_gen_framebuffer(GstGLESSink *sink)
     if (!gles->rgb_tex.id)
         GST_ERROR_OBJECT (sink, "Could not create RGB texture");
 
-    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB, GST_VIDEO_SINK_WIDTH (sink),
-                  GST_VIDEO_SINK_HEIGHT (sink), 0, GL_RGB,
-                  GL_UNSIGNED_BYTE, NULL);
+    gl_alloc_frame_textures (sink);
 
     glBindFramebuffer (GL_FRAMEBUFFER, gles->framebuffer);
     glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                             GL_TEXTURE_2D, gles->rgb_tex.id, 0);
-}
 
-static void
-gl_init_textures (GstGLESSink *sink)
-{
-    sink->gl_thread.gles.y_tex.id = gl_create_texture(GL_NEAREST);
-    sink->gl_thread.gles.u_tex.id = gl_create_texture(GL_NEAREST);
-    sink->gl_thread.gles.v_tex.id = gl_create_texture(GL_NEAREST);
+    /* filled in by the first onscreen pass */
+    glGenBuffers (1, &gles->onscreen_vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, gles->onscreen_vbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof (gles->onscreen_vertices), NULL,
+                  GL_DYNAMIC_DRAW);
+    memset (&gles->geometry, 0, sizeof (GstGLESGeometry));
+
+    gl_state_invalidate (&gles->state);
 }
 
 static void
@@ -178,8 +406,13 @@ gl_load_texture (GstGLESSink *sink, GstBuffer *buf)
 #if GST_CHECK_VERSION(1, 0, 0)
     GstMapInfo bufmap;
     guint8 *data;
+    gboolean mapped;
+
+    gl_timer_begin (&sink->gl_thread.gles.timer, STAGE_MAP);
+    mapped = gst_buffer_map (buf, &bufmap, GST_MAP_READ);
+    gl_timer_end (&sink->gl_thread.gles.timer, STAGE_MAP);
 
-    if (G_UNLIKELY(!gst_buffer_map (buf, &bufmap, GST_MAP_READ))) {
+    if (G_UNLIKELY(!mapped)) {
 	GST_WARNING_OBJECT (sink, "%s: Failed to map buffer data", __func__);
 	return;
     }
@@ -190,93 +423,206 @@ gl_load_texture (GstGLESSink *sink, GstBuffer *buf)
 #endif
 
     GstGLESContext *gles = &sink->gl_thread.gles;
-    /* y component */
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture (GL_TEXTURE_2D, gles->y_tex.id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, GST_VIDEO_SINK_WIDTH (sink),
-                 GST_VIDEO_SINK_HEIGHT (sink), 0, GL_LUMINANCE,
-                 GL_UNSIGNED_BYTE, data);
-    glUniform1i (gles->y_tex.loc, 0);
-
-    /* u component */
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture (GL_TEXTURE_2D, gles->u_tex.id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE,
-                 GST_VIDEO_SINK_WIDTH (sink)/2,
-                 GST_VIDEO_SINK_HEIGHT (sink)/2, 0, GL_LUMINANCE,
-                 GL_UNSIGNED_BYTE, data +
-                 GST_VIDEO_SINK_WIDTH (sink) * GST_VIDEO_SINK_HEIGHT (sink));
-    glUniform1i (gles->u_tex.loc, 1);
-
-    /* v component */
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture (GL_TEXTURE_2D, gles->v_tex.id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE,
-                 GST_VIDEO_SINK_WIDTH (sink)/2,
-                 GST_VIDEO_SINK_HEIGHT (sink)/2, 0, GL_LUMINANCE,
-                 GL_UNSIGNED_BYTE, data +
-                 GST_VIDEO_SINK_WIDTH (sink) * GST_VIDEO_SINK_HEIGHT (sink) +
-                 GST_VIDEO_SINK_WIDTH (sink)/2 *
-                 GST_VIDEO_SINK_HEIGHT (sink)/2);
-    glUniform1i (gles->v_tex.loc, 2);
+#if GST_CHECK_VERSION(1, 0, 0)
+    GstVideoInfo *info = &sink->info;
+    const guint8 *planes[3] = {
+        data + GST_VIDEO_INFO_PLANE_OFFSET (info, 0),
+        data + GST_VIDEO_INFO_PLANE_OFFSET (info, 1),
+        data + GST_VIDEO_INFO_PLANE_OFFSET (info, 2)
+    };
+    const gint strides[3] = {
+        GST_VIDEO_INFO_PLANE_STRIDE (info, 0),
+        GST_VIDEO_INFO_PLANE_STRIDE (info, 1),
+        GST_VIDEO_INFO_PLANE_STRIDE (info, 2)
+    };
+#else
+    gint width = GST_VIDEO_SINK_WIDTH (sink);
+    gint height = GST_VIDEO_SINK_HEIGHT (sink);
+    const guint8 *planes[3] = {
+        data,
+        data + width * height,
+        data + width * height + width / 2 * height / 2
+    };
+    const gint strides[3] = { width, width / 2, width / 2 };
+#endif
+
+    gl_timer_begin (&gles->timer, STAGE_UPLOAD);
+    gl_grid_upload (&gles->grid, &gles->state, planes, strides);
+    gl_timer_end (&gles->timer, STAGE_UPLOAD);
 
 #if GST_CHECK_VERSION(1, 0, 0)
     gst_buffer_unmap(buf, &bufmap);
 #endif
 }
 
+/* the fbo pass renders into the lower left part of the rgb texture when
+ * the quality governor shrinks it */
+static gfloat
+gl_fbo_scale (GstGLESSink *sink)
+{
+    return sink->gl_thread.quality >= GST_GLES_QUALITY_HALF_FBO ? 0.5f : 1.0f;
+}
+
 static void
 gl_draw_fbo (GstGLESSink *sink, GstBuffer *buf)
 {
-    GLfloat vVertices[] =
-    {
-        -1.0f, -1.0f,
-        0.0f, 1.0f,
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    GstGLESShader *shader = &gles->deinterlace;
+    gfloat scale = gl_fbo_scale (sink);
 
-        1.0f, -1.0f,
-        1.0f, 1.0f,
+    if (!sink->deinterlace ||
+        sink->gl_thread.quality >= GST_GLES_QUALITY_NO_DEINTERLACE)
+        shader = &gles->convert;
 
-        1.0f, 1.0f,
-        1.0f, 0.0f,
+    /* upload first, so the fbo pass can be timed on its own */
+    gl_load_texture(sink, buf);
 
-        -1.0f, 1.0f,
-        0.0f, 0.0f,
-    };
-    GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+    gl_timer_begin (&gles->timer, STAGE_FBO);
+    gl_state_bind_framebuffer (&gles->state, gles->framebuffer);
+    gl_state_use_program (&gles->state, shader->program);
+
+    gl_state_viewport (&gles->state, 0, 0, gles->fbo_width * scale,
+                       gles->fbo_height * scale);
+
+    glClear (GL_COLOR_BUFFER_BIT);
+
+    /* one quad per cell of the grid, indexed like the fullscreen quad of
+     * the pool */
+    gl_grid_draw (&gles->grid, &gles->state,
+                  shader == &gles->deinterlace ? gles->line_height_loc : -1,
+                  gles->quad_ibo);
+    gl_timer_end (&gles->timer, STAGE_FBO);
+}
+
+/* checks whether the back buffer still holds the borders drawn for the
+ * current geometry, in which case only the video rectangle is redrawn */
+static gboolean
+egl_back_buffer_valid (GstGLESSink *sink, const GstVideoRectangle *rect)
+{
     GstGLESContext *gles = &sink->gl_thread.gles;
+    EGLint age = 0;
+
+    /* the age has to be queried before the damage region can be set */
+    if (gles->buffer_age &&
+        !eglQuerySurface (gles->display, gles->surface,
+                          EGL_BUFFER_AGE_EXT, &age))
+        age = 0;
+
+    if (rect->x != gles->video_rect.x || rect->y != gles->video_rect.y ||
+        rect->w != gles->video_rect.w || rect->h != gles->video_rect.h ||
+        sink->window.width != gles->surface_width ||
+        sink->window.height != gles->surface_height) {
+        GST_DEBUG_OBJECT (sink, "Geometry changed, redraw borders");
+        gles->video_rect = *rect;
+        gles->surface_width = sink->window.width;
+        gles->surface_height = sink->window.height;
+        gles->frames_drawn = 0;
+        return FALSE;
+    }
 
-    glBindFramebuffer (GL_FRAMEBUFFER, gles->framebuffer);
-    glUseProgram (gles->deinterlace.program);
+    if (gles->buffer_age)
+        return age > 0 && (guint) age <= gles->frames_drawn;
 
-    glViewport(0, 0, GST_VIDEO_SINK_WIDTH (sink),
-               GST_VIDEO_SINK_HEIGHT (sink));
+    return gles->preserved && gles->frames_drawn > 0;
+}
 
-    glClear (GL_COLOR_BUFFER_BIT);
+/* binds the window through the state cache, except on the first bind
+ * of a surfaceless window, which sets up its framebuffer */
+static void
+gl_bind_window (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
 
-    glVertexAttribPointer (gles->deinterlace.position_loc, 2,
-                           GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat),
-                           vVertices);
+    if (!sink->window.backend->create_surface && !sink->window.framebuffer) {
+        gst_gles_window_bind (&sink->window);
+        gl_state_invalidate (&gles->state);
+        gles->state.framebuffer = sink->window.framebuffer;
+        return;
+    }
 
-    glVertexAttribPointer (gles->deinterlace.texcoord_loc, 2,
-                           GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat),
-                           &vVertices[2]);
+    gl_state_bind_framebuffer (&gles->state, sink->window.framebuffer);
+}
 
-    glEnableVertexAttribArray (gles->deinterlace.position_loc);
-    glEnableVertexAttribArray (gles->deinterlace.texcoord_loc);
+/* reads the whole window back and posts it, top row first, so tests can
+ * compare what was presented against the expected colours. Has to run
+ * before the swap, the back buffer is undefined afterwards. */
+static void
+gl_post_readback (GstGLESSink *sink)
+{
+    gint width = sink->window.width;
+    gint height = sink->window.height;
+    gsize stride = width * 4;
+    guint8 *pixels;
+    guint8 *flipped;
+    GstBuffer *buf;
+    GstStructure *s;
+    gint y;
+
+    pixels = g_malloc (stride * height);
+    flipped = g_malloc (stride * height);
+
+    gl_bind_window (sink);
+    glPixelStorei (GL_PACK_ALIGNMENT, 4);
+    glReadPixels (0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    /* gl rows start at the bottom */
+    for (y = 0; y < height; y++)
+        memcpy (flipped + y * stride, pixels + (height - 1 - y) * stride,
+                stride);
+    g_free (pixels);
 
-    gl_load_texture(sink, buf);
-    GLint line_height_loc =
-            glGetUniformLocation(gles->deinterlace.program,
-                                 "line_height");
-    glUniform1f(line_height_loc, 1.0/sink->video_height);
+#if GST_CHECK_VERSION(1, 0, 0)
+    buf = gst_buffer_new_wrapped (flipped, stride * height);
+#else
+    buf = gst_buffer_new ();
+    GST_BUFFER_DATA (buf) = GST_BUFFER_MALLOCDATA (buf) = flipped;
+    GST_BUFFER_SIZE (buf) = stride * height;
+#endif
+
+    s = gst_structure_new ("GstGLESSinkReadback",
+                           "width", G_TYPE_INT, width,
+                           "height", G_TYPE_INT, height,
+                           "buffer", GST_TYPE_BUFFER, buf, NULL);
+    gst_buffer_unref (buf);
 
-    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
+    gst_element_post_message (GST_ELEMENT (sink),
+                              gst_message_new_element (GST_OBJECT (sink), s));
 }
 
-void
-gl_draw_onscreen (GstGLESSink *sink)
+/* picks the filter for the onscreen pass. Factors below
+ * SCALE_MIPMAP_FACTOR are left to the mipmaps where the GL has them,
+ * the kernels are meant for upscales and mild downscales. Returns
+ * whether the scaler should run */
+static gboolean
+gl_select_scaling (GstGLESSink *sink, gdouble factor, gboolean *mipmap)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    GstGLESScaling scaling = sink->scaling;
+
+    *mipmap = gles->npot_mipmaps && factor < SCALE_MIPMAP_FACTOR;
+    if (*mipmap || sink->gl_thread.quality >= GST_GLES_QUALITY_BILINEAR)
+        scaling = GST_GLES_SCALING_BILINEAR;
+
+    if (scaling == GST_GLES_SCALING_BILINEAR)
+        return FALSE;
+
+    /* a program that failed to build is not retried until the filter
+     * changes */
+    if (gles->scaler.scaling != scaling) {
+        gl_scaler_init (GST_ELEMENT (sink), &gles->scaler, scaling);
+        gl_state_invalidate (&gles->state);
+    }
+
+    return gles->scaler.program.program != 0;
+}
+
+/* recomputes the onscreen quad with the cropped texture coordinates and
+ * the rectangle of the window it is drawn to, only when the crop, the
+ * video, the window or the fbo size changed since the last frame */
+static void
+gl_update_geometry (GstGLESSink *sink)
 {
-    GLfloat vVertices[] =
+    static const GLfloat quad[] =
     {
         -1.0f, -1.0f,
         0.0f, 0.0f,
@@ -290,72 +636,245 @@ gl_draw_onscreen (GstGLESSink *sink)
         -1.0f, 1.0f,
         0.0f, 1.0f,
     };
-    GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
-
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    GLfloat *vertices = gles->onscreen_vertices;
+    GstGLESGeometry geometry;
     GstVideoRectangle src;
     GstVideoRectangle dst;
-    GstVideoRectangle result;
-
-    GstGLESContext *gles = &sink->gl_thread.gles;
+    float crop_left, crop_right, crop_top, crop_bottom;
+    guint i;
+
+    memset (&geometry, 0, sizeof (GstGLESGeometry));
+    geometry.crop_top = sink->crop_top;
+    geometry.crop_bottom = sink->crop_bottom;
+    geometry.crop_left = sink->crop_left;
+    geometry.crop_right = sink->crop_right;
+    geometry.video_width = sink->video_width;
+    geometry.video_height = sink->video_height;
+    geometry.window_width = sink->window.width;
+    geometry.window_height = sink->window.height;
+    geometry.fbo_width = gles->fbo_width;
+    geometry.fbo_height = gles->fbo_height;
+    geometry.fbo_scale = gl_fbo_scale (sink);
+
+    if (memcmp (&geometry, &gles->geometry, sizeof (GstGLESGeometry)) == 0)
+        return;
+    gles->geometry = geometry;
 
     /* add cropping to texture coordinates */
-    float crop_left = (float)sink->crop_left / sink->video_width;
-    float crop_right = (float)sink->crop_right / sink->video_width;
-    float crop_top = (float)sink->crop_top / sink->video_height;
-    float crop_bottom = (float)sink->crop_bottom / sink->video_height;
-
-    vVertices[2] += crop_left;
-    vVertices[3] += crop_bottom;
-    vVertices[6] -= crop_right;
-    vVertices[7] += crop_bottom;
-    vVertices[10] -= crop_right;
-    vVertices[11] -= crop_top;
-    vVertices[14] += crop_left;
-    vVertices[15] -= crop_top;
+    crop_left = (float)sink->crop_left / sink->video_width;
+    crop_right = (float)sink->crop_right / sink->video_width;
+    crop_top = (float)sink->crop_top / sink->video_height;
+    crop_bottom = (float)sink->crop_bottom / sink->video_height;
+
+    memcpy (vertices, quad, sizeof (quad));
+    vertices[2] += crop_left;
+    vertices[3] += crop_bottom;
+    vertices[6] -= crop_right;
+    vertices[7] += crop_bottom;
+    vertices[10] -= crop_right;
+    vertices[11] -= crop_top;
+    vertices[14] += crop_left;
+    vertices[15] -= crop_top;
+
+    /* only part of the rgb texture may have been rendered to */
+    for (i = 2; i < G_N_ELEMENTS (gles->onscreen_vertices); i += 4) {
+        vertices[i] *= geometry.fbo_scale;
+        vertices[i + 1] *= geometry.fbo_scale;
+    }
+
+    gl_state_bind_buffers (&gles->state, gles->onscreen_vbo, gles->quad_ibo);
+    glBufferSubData (GL_ARRAY_BUFFER, 0, sizeof (gles->onscreen_vertices),
+                     vertices);
 
     dst.x = 0;
     dst.y = 0;
-    dst.w = sink->x11.width;
-    dst.h = sink->x11.height;
+    dst.w = sink->window.width;
+    dst.h = sink->window.height;
 
     src.x = 0;
     src.y = 0;
     src.w = sink->video_width - sink->crop_left - sink->crop_right;
     src.h = sink->video_height - sink->crop_top - sink->crop_bottom;
 
-    gst_video_sink_center_rect(src, dst, &result, TRUE);
+    gst_video_sink_center_rect(src, dst, &gles->onscreen_rect, TRUE);
 
-    glUseProgram (gles->scale.program);
-    glBindFramebuffer (GL_FRAMEBUFFER, 0);
+    /* the part of the rgb texture shown, in texels */
+    gles->source_width = MAX ((vertices[6] - vertices[2]) * gles->fbo_width,
+                              1.0);
+    gles->source_height = MAX ((vertices[15] - vertices[3]) *
+                               gles->fbo_height, 1.0);
 
-    glViewport (result.x, result.y, result.w, result.h);
+    GST_DEBUG_OBJECT (sink, "Onscreen quad of %.0fx%.0f texels drawn to "
+                      "%dx%d at %d,%d", gles->source_width,
+                      gles->source_height, gles->onscreen_rect.w,
+                      gles->onscreen_rect.h, gles->onscreen_rect.x,
+                      gles->onscreen_rect.y);
+}
 
-    glClear (GL_COLOR_BUFFER_BIT);
+void
+gl_draw_onscreen (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    GstVideoRectangle result;
+    EGLint damage[4];
+    gboolean valid;
+    gboolean kernel;
+    gboolean mipmap;
+
+    gl_update_geometry (sink);
+    result = gles->onscreen_rect;
+
+    kernel = gl_select_scaling (sink,
+                                MIN (result.w / gles->source_width,
+                                     result.h / gles->source_height),
+                                &mipmap);
+
+    /* only the video rectangle is damaged as long as the letterbox
+     * borders in the back buffer are still valid */
+    valid = egl_back_buffer_valid (sink, &result);
+    if (valid) {
+        damage[0] = result.x;
+        damage[1] = result.y;
+        damage[2] = result.w;
+        damage[3] = result.h;
+    } else {
+        damage[0] = 0;
+        damage[1] = 0;
+        damage[2] = sink->window.width;
+        damage[3] = sink->window.height;
+    }
 
-    glVertexAttribPointer (gles->scale.position_loc, 2, GL_FLOAT,
-        GL_FALSE, 4 * sizeof (GLfloat), vVertices);
+    gl_timer_begin (&gles->timer, STAGE_ONSCREEN);
+    if (gles->set_damage_region)
+        gles->set_damage_region (gles->display, gles->surface, damage, 1);
 
-    glVertexAttribPointer (gles->scale.texcoord_loc, 2, GL_FLOAT,
-        GL_FALSE, 4 * sizeof (GLfloat), &vVertices[2]);
+    gl_state_bind_texture (&gles->state, 3, gles->rgb_tex.id);
 
-    glEnableVertexAttribArray (gles->scale.position_loc);
-    glEnableVertexAttribArray (gles->scale.texcoord_loc);
+    /* the fbo pass just rewrote level 0 */
+    if (mipmap)
+        glGenerateMipmap (GL_TEXTURE_2D);
+    if (mipmap != gles->mipmapped) {
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                         mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        gles->mipmapped = mipmap;
+    }
 
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture (GL_TEXTURE_2D, gles->rgb_tex.id);
-    glUniform1i (gles->rgb_tex.loc, 3);
+    /* the kernels scale the width first, into a texture as high as the
+     * source part */
+    if (kernel)
+        gl_scaler_horizontal (&gles->scaler, &gles->state,
+                              gles->onscreen_vertices, gles->onscreen_vbo,
+                              gles->quad_ibo, result.w,
+                              (gint) (gles->source_height + 0.5),
+                              gles->fbo_width);
+
+    gl_bind_window (sink);
+
+    gl_state_viewport (&gles->state, result.x, result.y, result.w, result.h);
 
-    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices);
-    eglSwapBuffers (gles->display, gles->surface);
+    if (!valid)
+        glClear (GL_COLOR_BUFFER_BIT);
+
+    if (kernel) {
+        gl_scaler_vertical (&gles->scaler, &gles->state, gles->quad_ibo);
+    } else {
+        gl_state_use_program (&gles->state, gles->scale.program);
+        gl_state_quad_attributes (&gles->state, gles->onscreen_vbo,
+                                  gles->quad_ibo, 0);
+        glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT,
+                        (const GLvoid *) 0);
+    }
+    gl_timer_end (&gles->timer, STAGE_ONSCREEN);
+
+    if (sink->readback)
+        gl_post_readback (sink);
+
+    gl_timer_begin (&gles->timer, STAGE_SWAP);
+    gles->swap_start = gst_util_get_timestamp ();
+    if (gles->swap_with_damage)
+        gles->swap_with_damage (gles->display, gles->surface, damage, 1);
+    else
+        gst_gles_window_swap (&sink->window, gles->display, gles->surface);
+    gles->swap_end = gst_util_get_timestamp ();
+    gl_timer_end (&gles->timer, STAGE_SWAP);
+    gles->frames_drawn++;
 }
 
 /* EGL implementation */
+static gboolean
+egl_extension_available (EGLDisplay display, const gchar *extension)
+{
+    const gchar *egl_extensions = eglQueryString (display, EGL_EXTENSIONS);
+    return (egl_extensions &&
+            g_strstr_len (egl_extensions, -1, extension) != NULL);
+}
+
+/* applies the requested swap interval, clamped to what the config
+ * supports. negative values leave the driver default untouched */
+static void
+egl_set_swap_interval (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    EGLint min_interval = 0;
+    EGLint max_interval = 1;
+    gint interval = sink->swap_interval;
+
+    gles->requested_interval = interval;
+    if (!gles->surface) {
+        GST_DEBUG_OBJECT (sink, "No surface, nothing is swapped");
+        return;
+    }
+    if (interval < 0) {
+        GST_DEBUG_OBJECT (sink, "Keep driver default swap interval");
+        return;
+    }
+
+    eglGetConfigAttrib (gles->display, gles->config, EGL_MIN_SWAP_INTERVAL,
+                        &min_interval);
+    eglGetConfigAttrib (gles->display, gles->config, EGL_MAX_SWAP_INTERVAL,
+                        &max_interval);
+    interval = CLAMP (interval, min_interval, max_interval);
+
+    if (!eglSwapInterval (gles->display, interval)) {
+        GST_WARNING_OBJECT (sink, "Could not set swap interval %d: 0x%04x",
+                            interval, eglGetError ());
+        return;
+    }
+
+    if (interval != sink->swap_interval)
+        GST_WARNING_OBJECT (sink, "Swap interval %d not supported, using %d",
+                            sink->swap_interval, interval);
+
+    gles->swap_interval = interval;
+}
+
+static gchar *
+egl_describe_swap_mode (GstGLESSink *sink)
+{
+    GstGLESContext *gles = &sink->gl_thread.gles;
+    const gchar *behavior;
+
+    if (!gles->context)
+        return g_strdup ("none");
 
+    if (gles->buffer_age)
+        behavior = "buffer-age";
+    else if (gles->preserved)
+        behavior = "preserved";
+    else
+        behavior = "destroyed";
+
+    if (gles->swap_interval < 0)
+        return g_strdup_printf ("interval default, %s", behavior);
+
+    return g_strdup_printf ("interval %d, %s", gles->swap_interval, behavior);
+}
 
 static gint
 egl_init (GstGLESSink *sink)
 {
-    const EGLint configAttribs[] =
+    EGLint configAttribs[] =
     {
         EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
@@ -369,51 +888,83 @@ egl_init (GstGLESSink *sink)
         EGL_NONE
     };
 
-    EGLConfig config;
     EGLint num_configs;
-    EGLint major;
-    EGLint minor;
+    gchar *swap_mode;
+    GstClockTime t = gst_util_get_timestamp ();
 
     GstGLESContext *gles = &sink->gl_thread.gles;
 
-    GST_DEBUG_OBJECT (sink, "egl get display");
-    gles->display = eglGetDisplay((EGLNativeDisplayType)
-                                          sink->x11.display);
-    if (gles->display == EGL_NO_DISPLAY) {
-        GST_ERROR_OBJECT(sink, "Could not get EGL display");
-        return -1;
-    }
+    /* the pool has initialized the display already */
+    gles->display = gles->pool->display;
+    configAttribs[1] = gles->pool->backend->surface_type;
 
-    GST_DEBUG_OBJECT (sink, "egl initialize");
-    if (!eglInitialize(gles->display, &major, &minor)) {
-        GST_ERROR_OBJECT(sink, "Could not initialize EGL context");
-        return -1;
-    }
-    GST_DEBUG_OBJECT (sink, "Have EGL version: %d.%d", major, minor);
+    /* in low latency mode we want to know what is left in the back
+     * buffer, either by its age or by having it preserved on swap */
+    gles->buffer_age = sink->low_latency &&
+            (egl_extension_available (gles->display, "EGL_EXT_buffer_age") ||
+             egl_extension_available (gles->display,
+                                      "EGL_KHR_partial_update"));
+    gles->preserved = FALSE;
+    if (sink->low_latency && !gles->buffer_age)
+        configAttribs[1] |= EGL_SWAP_BEHAVIOR_PRESERVED_BIT;
 
     GST_DEBUG_OBJECT (sink, "choose config");
-    if (!eglChooseConfig(gles->display, configAttribs, &config, 1,
+    if (!eglChooseConfig(gles->display, configAttribs, &gles->config, 1,
                         &num_configs)) {
         GST_ERROR_OBJECT(sink, "Could not choose EGL config");
         return -1;
     }
 
+    if (num_configs < 1 &&
+        (configAttribs[1] & EGL_SWAP_BEHAVIOR_PRESERVED_BIT)) {
+        GST_WARNING_OBJECT(sink, "No config with preserved swap behaviour, "
+                           "falling back to the default");
+        configAttribs[1] = gles->pool->backend->surface_type;
+        if (!eglChooseConfig(gles->display, configAttribs, &gles->config, 1,
+                            &num_configs)) {
+            GST_ERROR_OBJECT(sink, "Could not choose EGL config");
+            return -1;
+        }
+    }
+
     if (num_configs != 1) {
         GST_WARNING_OBJECT(sink, "Did not get exactly one config, but %d",
                            num_configs);
     }
+    gl_startup_mark (sink, GST_GLES_STARTUP_EGL_CONFIG, &t);
 
     GST_DEBUG_OBJECT (sink, "create window surface");
-    gles->surface = eglCreateWindowSurface(gles->display, config,
-                                     sink->x11.window, NULL);
-    if (gles->surface == EGL_NO_SURFACE) {
+    gles->surface = gst_gles_window_create_surface (&sink->window,
+                                                    gles->display,
+                                                    gles->config);
+    if (gles->surface == EGL_NO_SURFACE &&
+        gles->pool->backend->surface_type) {
         GST_ERROR_OBJECT (sink, "Could not create EGL surface");
         return -1;
     }
 
+    if (gles->surface &&
+        (configAttribs[1] & EGL_SWAP_BEHAVIOR_PRESERVED_BIT)) {
+        gles->preserved = eglSurfaceAttrib (gles->display, gles->surface,
+                                            EGL_SWAP_BEHAVIOR,
+                                            EGL_BUFFER_PRESERVED);
+        if (!gles->preserved)
+            GST_WARNING_OBJECT (sink, "Could not preserve buffer on swap");
+    }
+    gl_startup_mark (sink, GST_GLES_STARTUP_EGL_SURFACE, &t);
+
     GST_DEBUG_OBJECT (sink, "egl create context");
-    gles->context = eglCreateContext(gles->display, config,
+    gles->shared = gles->pool->context != NULL;
+    gles->context = eglCreateContext(gles->display, gles->config,
+                                     gles->shared ? gles->pool->context :
                                      EGL_NO_CONTEXT, contextAttribs);
+    if (gles->context == EGL_NO_CONTEXT && gles->shared) {
+        GST_WARNING_OBJECT (sink, "Could not join the shared context "
+                            "group, using a private one");
+        gles->shared = FALSE;
+        gles->context = eglCreateContext(gles->display, gles->config,
+                                         EGL_NO_CONTEXT, contextAttribs);
+    }
     if (gles->context == EGL_NO_CONTEXT) {
         GST_ERROR_OBJECT(sink, "Could not create EGL context");
         return -1;
@@ -425,257 +976,632 @@ egl_init (GstGLESSink *sink)
         GST_ERROR_OBJECT(sink, "Could not set EGL context to current");
         return -1;
     }
+    gl_startup_mark (sink, GST_GLES_STARTUP_EGL_CONTEXT, &t);
+
+    gles->swap_interval = -1;
+    egl_set_swap_interval (sink);
+
+    gles->swap_with_damage = NULL;
+    if (!gles->surface)
+        GST_DEBUG_OBJECT (sink, "No surface, draw offscreen");
+    else if (egl_extension_available (gles->display,
+                                      "EGL_KHR_swap_buffers_with_damage"))
+        gles->swap_with_damage = (GstGLESSwapWithDamage)
+                eglGetProcAddress ("eglSwapBuffersWithDamageKHR");
+    else if (egl_extension_available (gles->display,
+                                      "EGL_EXT_swap_buffers_with_damage"))
+        gles->swap_with_damage = (GstGLESSwapWithDamage)
+                eglGetProcAddress ("eglSwapBuffersWithDamageEXT");
+
+    gles->set_damage_region = NULL;
+    if (gles->surface && gles->buffer_age &&
+        egl_extension_available (gles->display, "EGL_KHR_partial_update"))
+        gles->set_damage_region = (GstGLESSetDamageRegion)
+                eglGetProcAddress ("eglSetDamageRegionKHR");
+
+    gles->frames_drawn = 0;
+
+    swap_mode = egl_describe_swap_mode (sink);
+    GST_INFO_OBJECT (sink, "Selected swap mode: %s", swap_mode);
+    g_free (swap_mode);
 
     GST_DEBUG_OBJECT (sink, "egl init done");
 
     return 0;
 }
 
-/*
- * ugly quirk, to workaround nvidia bugs
- * closes left open file handles
- */
-
 static void
-egl_close_file (GstGLESSink *sink, const gchar *filename)
-{
-    const gchar *target_file;
-    GError *err = NULL;
-    GFileInfo *info;
-    GFile *file;
-
-    GST_DEBUG_OBJECT (sink, "Check file handle: %s", filename);
-
-    file = g_file_new_for_path (filename);
-    info = g_file_query_info (file, "*",
-                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                              NULL, &err);
-    if (!info || err) {
-        GST_ERROR_OBJECT (sink, "Could get file info: %s",
-                         err->message);
-        g_error_free(err);
-        goto cleanup;
+egl_close(GstGLESSink *sink)
+{
+    GstGLESContext *context = &sink->gl_thread.gles;
+
+    const GLuint framebuffers[] = {
+        context->framebuffer
+    };
+
+    const GLuint textures[] = {
+        context->rgb_tex.id
+    };
+
+    if (context->context)
+        gl_timer_close (&context->timer);
+
+    if (context->initialized) {
+        glDeleteFramebuffers (G_N_ELEMENTS(framebuffers), framebuffers);
+        glDeleteTextures (G_N_ELEMENTS(textures), textures);
+        glDeleteBuffers (1, &context->onscreen_vbo);
+        context->onscreen_vbo = 0;
+        gl_grid_free (&context->grid);
+        if (context->lut_tex)
+            glDeleteTextures (1, &context->lut_tex);
+        context->lut_tex = 0;
+        g_free (context->yuv_defines);
+        context->yuv_defines = NULL;
+        memset (&context->color, 0, sizeof (GstGLESColor));
+        context->mipmapped = FALSE;
+        gl_scaler_free (&context->scaler);
+        gl_delete_shader (&context->scale);
+        gl_delete_shader (&context->convert);
+        gl_delete_shader (&context->deinterlace);
     }
 
-    GST_DEBUG_OBJECT (sink, "File type is: %d",
-                     g_file_info_get_file_type(info));
+    if (context->context)
+        gst_gles_window_release (&sink->window);
 
-    if (!g_file_info_get_is_symlink (info)) {
-        GST_DEBUG_OBJECT (sink, "File is no symlink");
-        goto cleanup;
+    if (context->context && !context->shared &&
+        context->quad_vbo) {
+        glDeleteBuffers (1, &context->quad_vbo);
+        glDeleteBuffers (1, &context->quad_ibo);
     }
+    context->quad_vbo = 0;
+    context->quad_ibo = 0;
 
-    target_file = g_file_info_get_symlink_target (info);
-    GST_DEBUG_OBJECT (sink, "Check file resolves to: '%s'",
-                      target_file);
+    /* the display belongs to the pool, only release what is ours */
+    if (context->display)
+        eglMakeCurrent (context->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                        EGL_NO_CONTEXT);
 
-    if (g_str_equal (target_file, "/dev/tegra_sema") ||
-        g_str_equal (target_file, "/dev/nvhost-gr2d") ||
-        g_str_equal (target_file, "/dev/nvhost-gr3d"))
-    {
-        gchar *basename = g_file_get_basename (file);
-        gint64 fid = g_ascii_strtoll (basename, NULL, 10);
-
-        if (fid > 0) {
-            GST_DEBUG_OBJECT (sink, "Close file handle %"
-                              G_GINT64_FORMAT, fid);
-            if (close (fid) < 0) {
-                GST_ERROR_OBJECT (sink,
-                                  "Could not close file handle: %d",
-                                  errno);
-            }
-        }
+    if (context->context) {
+        eglDestroyContext (context->display, context->context);
+        context->context = NULL;
+    }
 
-        g_free (basename);
+    if (context->surface) {
+        eglDestroySurface (context->display, context->surface) ;
+        context->surface = NULL;
     }
 
-cleanup:
-    g_object_unref (info);
-    g_object_unref (file);
+    context->display = NULL;
+    context->initialized = FALSE;
+}
+
+static gint
+x11_init (GstGLESSink *sink, gint width, gint height)
+{
+    GstGLESPool *pool = sink->gl_thread.gles.pool;
+    GstClockTime t = gst_util_get_timestamp ();
+    gint ret;
+
+    sink->window.backend = pool->backend;
+    ret = gst_gles_window_open (&sink->window, pool->native_display,
+                                "GLESSink", width, height);
+    gl_startup_mark (sink, GST_GLES_STARTUP_X11_WINDOW, &t);
+
+    return ret;
 }
 
 static void
-egl_close_handles (GstGLESSink *sink)
+x11_close (GstGLESSink *sink)
 {
-    GError *err = NULL;
-    GDir *directory;
-    const gchar *file;
-    gchar *path;
+    gst_gles_window_close (&sink->window);
+}
 
+static void
+x11_handle_events (gpointer data)
+{
+    GstGLESSink *sink = GST_GLES_SINK (data);
 
-    path = g_strdup_printf ("/proc/%u/fd", getpid());
-    GST_DEBUG_OBJECT (sink, "Check for dead file handles in %s", path);
+    if (gst_gles_window_handle_events (&sink->window))
+        gl_draw_onscreen (sink);
+}
 
-    directory = g_dir_open (path, 0, &err);
-    if (!directory || err) {
-        GST_ERROR_OBJECT(sink, "Could not list files: %s",
-                         err->message);
-        g_object_unref (err);
-        goto cleanup;
-    }
+/* Frame pacing */
+static GstClockTime
+gl_pacing_predict_vblank (GstGLESSink *sink, GstClockTime target)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstClockTime period = thread->vblank_period;
+    guint64 n;
 
-    while ((file = g_dir_read_name(directory))) {
-        gchar *filename = g_strconcat(path, "/", file, NULL);
-        egl_close_file (sink, filename);
-        g_free (filename);
-    }
+    /* without vsync the frame is shown as soon as it is swapped */
+    if (thread->gles.swap_interval == 0 ||
+        !GST_CLOCK_TIME_IS_VALID (thread->last_vblank))
+        return target;
+
+    if (target <= thread->last_vblank)
+        return thread->last_vblank + period;
 
-cleanup:
-    g_free (path);
-    g_dir_close (directory);
+    n = (target - thread->last_vblank + period - 1) / period;
+    return thread->last_vblank + n * period;
 }
 
+/* waits until the current buffer has to be rendered to hit the first
+ * vblank after its target time. returns FALSE when interrupted by a
+ * flush */
+static gboolean
+gl_pacing_wait (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstClockTime vblank, margin, start;
+    GstClockReturn ret;
+    GstClockID id;
+    GstClock *clock;
+
+    if (!GST_CLOCK_TIME_IS_VALID (thread->target))
+        return TRUE;
+
+    clock = gst_element_get_clock (GST_ELEMENT (sink));
+    if (!clock)
+        return TRUE;
+
+    /* finish rendering a bit before the vblank, but not so early that
+     * the swap still makes it to the one before */
+    vblank = gl_pacing_predict_vblank (sink, thread->target);
+    margin = thread->vblank_period / 4;
+    start = vblank > thread->render_cost + margin ?
+            vblank - thread->render_cost - margin : 0;
+
+    GST_LOG_OBJECT (sink, "Target %" GST_TIME_FORMAT ", vblank %"
+                    GST_TIME_FORMAT ", start rendering at %" GST_TIME_FORMAT,
+                    GST_TIME_ARGS (thread->target), GST_TIME_ARGS (vblank),
+                    GST_TIME_ARGS (start));
+
+    id = gst_clock_new_single_shot_id (clock, start);
+
+    GST_OBJECT_LOCK (sink);
+    if (thread->flushing) {
+        GST_OBJECT_UNLOCK (sink);
+        gst_clock_id_unref (id);
+        gst_object_unref (clock);
+        return FALSE;
+    }
+    thread->clock_id = id;
+    GST_OBJECT_UNLOCK (sink);
+
+    ret = gst_clock_id_wait (id, NULL);
+
+    GST_OBJECT_LOCK (sink);
+    thread->clock_id = NULL;
+    GST_OBJECT_UNLOCK (sink);
+
+    gst_clock_id_unref (id);
+    gst_object_unref (clock);
+
+    return ret != GST_CLOCK_UNSCHEDULED;
+}
 
 static void
-egl_close(GstGLESSink *sink)
+gl_pacing_unschedule (GstGLESSink *sink)
 {
-    GstGLESContext *context = &sink->gl_thread.gles;
+    GST_OBJECT_LOCK (sink);
+    sink->gl_thread.flushing = TRUE;
+    if (sink->gl_thread.clock_id)
+        gst_clock_id_unschedule (sink->gl_thread.clock_id);
+    GST_OBJECT_UNLOCK (sink);
+}
 
-    const GLuint framebuffers[] = {
-        context->framebuffer
-    };
+/* called after the swap, refines the vblank estimate from the swap
+ * completion time and reports when the frame was actually presented */
+static void
+gl_pacing_update (GstGLESSink *sink, GstClockTime draw_start)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstClockTime cost = thread->gles.swap_start - draw_start;
+    GstClockTime now, delta, vblank;
+    GstClock *clock;
+    guint64 n;
+
+    thread->render_cost = thread->render_cost ?
+            (thread->render_cost * 7 + cost) / 8 : cost;
+
+    clock = gst_element_get_clock (GST_ELEMENT (sink));
+    if (!clock)
+        return;
+
+    now = gst_clock_get_time (clock);
+    gst_object_unref (clock);
+
+    vblank = gl_pacing_predict_vblank (sink, thread->target);
+
+    /* swaps only complete on vblanks, so every interval is a multiple
+     * of the refresh period */
+    if (thread->gles.swap_interval != 0 &&
+        GST_CLOCK_TIME_IS_VALID (thread->last_vblank) &&
+        now > thread->last_vblank) {
+        delta = now - thread->last_vblank;
+        n = (delta + thread->vblank_period / 2) / thread->vblank_period;
+        if (n > 0 && n <= PACING_MAX_VBLANKS)
+            thread->vblank_period =
+                    (thread->vblank_period * 7 + delta / n) / 8;
+    }
+    thread->last_vblank = now;
+
+    if (sink->pacing && GST_CLOCK_TIME_IS_VALID (thread->target)) {
+        GstStructure *s;
+
+        GST_LOG_OBJECT (sink, "Presented at %" GST_TIME_FORMAT
+                        ", %" G_GINT64_FORMAT " ns after target",
+                        GST_TIME_ARGS (now),
+                        GST_CLOCK_DIFF (thread->target, now));
+
+        s = gst_structure_new ("GstGLESSinkPresented",
+                "target", G_TYPE_UINT64, thread->target,
+                "vblank", G_TYPE_UINT64, vblank,
+                "presented", G_TYPE_UINT64, now,
+                "error", G_TYPE_INT64, GST_CLOCK_DIFF (thread->target, now),
+                "vblank-period", G_TYPE_UINT64, thread->vblank_period,
+                NULL);
+        gst_element_post_message (GST_ELEMENT (sink),
+                gst_message_new_element (GST_OBJECT (sink), s));
+    }
+}
 
-    const GLuint textures[] = {
-        context->y_tex.id,
-        context->u_tex.id,
-        context->v_tex.id,
-        context->rgb_tex.id
-    };
+/* Latency */
 
-    if (context->initialized) {
-        glDeleteFramebuffers (G_N_ELEMENTS(framebuffers), framebuffers);
-        glDeleteTextures (G_N_ELEMENTS(textures), textures);
-        gl_delete_shader (&context->scale);
-        gl_delete_shader (&context->deinterlace);
+/*
+ * Tracks the time from the start of the upload until the swap returned
+ * and reports it as render delay, so the base class syncs buffers that
+ * much earlier and includes it in the latency query. With pacing the
+ * buffer has to arrive one refresh period earlier on top of that. A
+ * render-delay set by the application is kept and added to both.
+ */
+static void
+gl_update_latency (GstGLESSink *sink, GstClockTime draw_start)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstBaseSink *basesink = GST_BASE_SINK (sink);
+    GstClockTime latency = thread->gles.swap_end - draw_start;
+    GstClockTime delay, current, threshold;
+    gboolean user_changed;
+
+    thread->present_latency = thread->present_latency ?
+            (thread->present_latency * 7 + latency) / 8 : latency;
+
+    delay = thread->present_latency;
+    if (sink->pacing)
+        delay += thread->vblank_period;
+
+    /* anything but what we set last came from the application */
+    current = gst_base_sink_get_render_delay (basesink);
+    user_changed = current != sink->render_delay;
+    if (user_changed)
+        sink->user_render_delay = current;
+    delay += sink->user_render_delay;
+
+    /* only renegotiate the pipeline latency on meaningful changes */
+    threshold = MAX (LATENCY_THRESHOLD, current / 10);
+    if (user_changed || delay + threshold < current ||
+        current + threshold < delay) {
+        GST_DEBUG_OBJECT (sink, "Render delay changed from %" GST_TIME_FORMAT
+                          " to %" GST_TIME_FORMAT, GST_TIME_ARGS (current),
+                          GST_TIME_ARGS (delay));
+        gst_base_sink_set_render_delay (basesink, delay);
+        sink->render_delay = delay;
+        gst_element_post_message (GST_ELEMENT (sink),
+                gst_message_new_latency (GST_OBJECT (sink)));
     }
+}
 
-    if (context->context) {
-        eglDestroyContext (context->display, context->context);
-        context->context = NULL;
-    }
+/* QoS */
 
-    if (context->surface) {
-        eglDestroySurface (context->display, context->surface) ;
-        context->surface = NULL;
+/* lets max-lateness follow the frame budget, unless the application
+ * has set a value of its own */
+static void
+gst_gles_sink_update_max_lateness (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstBaseSink *basesink = GST_BASE_SINK (sink);
+    gint64 current = gst_base_sink_get_max_lateness (basesink);
+    gint64 budget;
+
+    if (current != sink->max_lateness)
+        return;
+
+    budget = DEFAULT_MAX_LATENESS;
+    if (GST_CLOCK_TIME_IS_VALID (sink->frame_duration))
+        budget = sink->frame_duration;
+    budget = MAX (budget, (gint64) (thread->render_cost +
+                                    thread->present_cost));
+
+    if (ABS (budget - current) > GST_MSECOND) {
+        GST_DEBUG_OBJECT (sink, "max-lateness %" GST_TIME_FORMAT,
+                          GST_TIME_ARGS (budget));
+        gst_base_sink_set_max_lateness (basesink, budget);
+        sink->max_lateness = budget;
     }
+}
 
-    if (context->display) {
-        eglTerminate (context->display);
-        context->display = NULL;
-    }
+/*
+ * The base class only sees how late a buffer reached the sink. If the
+ * frame ended up on screen after its target time anyway, tell upstream
+ * how late it was and what rendering and presenting it cost, so
+ * decoders can skip frames that could not be shown in time. The QoS
+ * event the base class sends for the same frame is dropped by
+ * gst_gles_sink_qos_probe, so upstream sees one event per frame.
+ */
+static void
+gl_update_qos (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstBaseSink *basesink = GST_BASE_SINK (sink);
+    GstClockTime gpu_cost = gl_timer_gpu_cost (&thread->gles.timer);
+    GstClockTime present_cost = thread->gles.swap_end -
+                                thread->gles.swap_start;
+    GstClockTimeDiff lateness;
+    GstClockTime budget;
+    gdouble proportion;
+    GstEvent *event;
+    GstClock *clock;
+
+    thread->present_cost = thread->present_cost ?
+            (thread->present_cost * 7 + present_cost) / 8 : present_cost;
+    gst_gles_sink_update_max_lateness (sink);
+
+    if (!GST_CLOCK_TIME_IS_VALID (thread->running_time) ||
+        !GST_CLOCK_TIME_IS_VALID (thread->target))
+        return;
+
+    clock = gst_element_get_clock (GST_ELEMENT (sink));
+    if (!clock)
+        return;
+
+    lateness = GST_CLOCK_DIFF (thread->target, gst_clock_get_time (clock));
+    gst_object_unref (clock);
+    if (lateness <= 0)
+        return;
+
+    gst_gles_stats_frame_late (&sink->stats);
+    if (!gst_base_sink_is_qos_enabled (basesink))
+        return;
+
+    budget = GST_CLOCK_TIME_IS_VALID (sink->frame_duration) ?
+            sink->frame_duration : thread->vblank_period;
+    proportion = (gdouble) (gpu_cost + present_cost) / budget;
+
+    GST_DEBUG_OBJECT (sink, "Presented %" G_GINT64_FORMAT " ns late, "
+                      "gpu %" GST_TIME_FORMAT ", present %" GST_TIME_FORMAT,
+                      lateness, GST_TIME_ARGS (gpu_cost),
+                      GST_TIME_ARGS (present_cost));
 
-    egl_close_handles (sink);
+#if GST_CHECK_VERSION(1, 0, 0)
+    event = gst_event_new_qos (GST_QOS_TYPE_OVERFLOW, proportion, lateness,
+                               thread->running_time);
+    gst_structure_set (gst_event_writable_structure (event),
+                       "gpu-cost", G_TYPE_UINT64, gpu_cost,
+                       "present-cost", G_TYPE_UINT64, present_cost,
+                       NULL);
+#else
+    event = gst_event_new_qos_full (GST_QOS_TYPE_OVERFLOW, proportion,
+                                    lateness, thread->running_time);
+#endif
 
-    context->initialized = FALSE;
+    gst_pad_push_event (GST_BASE_SINK_PAD (basesink), event);
+    g_atomic_int_set (&thread->qos_sent, TRUE);
 }
 
-static gint
-x11_init (GstGLESSink *sink, gint width, gint height)
+/* drops the QoS event of the base class for a frame gl_update_qos
+ * already sent one for */
+#if GST_CHECK_VERSION(1, 0, 0)
+static GstPadProbeReturn
+gst_gles_sink_qos_probe (GstPad *pad, GstPadProbeInfo *info, gpointer data)
 {
-    Window root;
-    XSetWindowAttributes swa;
-    XWMHints hints;
+    GstGLESSink *sink = GST_GLES_SINK (data);
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
 
-    sink->x11.display = XOpenDisplay (NULL);
-    if(!sink->x11.display) {
-        GST_ERROR_OBJECT(sink, "Could not create X display");
-        return -1;
+    if (GST_EVENT_TYPE (event) == GST_EVENT_QOS &&
+        g_atomic_int_compare_and_exchange (&sink->gl_thread.qos_sent,
+                                           TRUE, FALSE))
+        return GST_PAD_PROBE_DROP;
+
+    return GST_PAD_PROBE_OK;
+}
+#else
+static gboolean
+gst_gles_sink_qos_probe (GstPad *pad, GstEvent *event, gpointer data)
+{
+    GstGLESSink *sink = GST_GLES_SINK (data);
+
+    return GST_EVENT_TYPE (event) != GST_EVENT_QOS ||
+           !g_atomic_int_compare_and_exchange (&sink->gl_thread.qos_sent,
+                                               TRUE, FALSE);
+}
+#endif
+
+/* Adaptive quality */
+static void
+gl_set_quality (GstGLESSink *sink, GstGLESQuality quality,
+                const gchar *reason, GstClockTime cost, GstClockTime budget)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstStructure *s;
+
+    GST_INFO_OBJECT (sink, "Quality %s -> %s (%s), render cost %"
+                     GST_TIME_FORMAT ", budget %" GST_TIME_FORMAT,
+                     quality_names[thread->quality], quality_names[quality],
+                     reason, GST_TIME_ARGS (cost), GST_TIME_ARGS (budget));
+
+    thread->quality = quality;
+    thread->overload_frames = 0;
+    thread->headroom_frames = 0;
+
+    s = gst_structure_new ("GstGLESSinkQuality",
+            "level", G_TYPE_INT, quality,
+            "quality", G_TYPE_STRING, quality_names[quality],
+            "reason", G_TYPE_STRING, reason,
+            "render-cost", G_TYPE_UINT64, cost,
+            "budget", G_TYPE_UINT64, budget,
+            NULL);
+    gst_element_post_message (GST_ELEMENT (sink),
+            gst_message_new_element (GST_OBJECT (sink), s));
+}
+
+/*
+ * Steps the quality down after a few frames over budget and back up
+ * after a longer run of frames with headroom. Stepping down right after
+ * stepping up doubles the number of frames needed for the next attempt,
+ * so a load sitting between two levels does not make the quality flap.
+ *
+ * Submitting the draw calls is cheap, the gpu work shows up in the swap.
+ * The cost is the gpu time where timer queries measure it, else the
+ * time until the swap returned.
+ */
+static void
+gl_update_quality (GstGLESSink *sink, GstClockTime draw_start)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstGLESTimer *timer = &thread->gles.timer;
+    GstClockTime cost;
+    GstClockTime budget;
+
+    if (timer->gpu && timer->gpu_frames > 0)
+        cost = MAX (thread->gles.swap_start - draw_start,
+                    gl_timer_gpu_cost (timer));
+    else
+        cost = thread->gles.swap_end - draw_start;
+
+    budget = GST_CLOCK_TIME_IS_VALID (sink->frame_duration) ?
+            sink->frame_duration : thread->vblank_period;
+
+    if (!sink->adaptive_quality) {
+        if (thread->quality != GST_GLES_QUALITY_FULL)
+            gl_set_quality (sink, GST_GLES_QUALITY_FULL, "disabled",
+                            cost, budget);
+        return;
+    }
+
+    if (thread->frames_since_upgrade < G_MAXUINT)
+        thread->frames_since_upgrade++;
+
+    if (cost * 100 > budget * QUALITY_OVERLOAD_PERCENT) {
+        thread->headroom_frames = 0;
+        if (++thread->overload_frames < QUALITY_DOWNGRADE_FRAMES ||
+            thread->quality == GST_GLES_QUALITY_LOWEST)
+            return;
+
+        if (thread->frames_since_upgrade < thread->upgrade_frames * 2)
+            thread->upgrade_frames = MIN (thread->upgrade_frames * 2,
+                                          QUALITY_MAX_UPGRADE_FRAMES);
+        gl_set_quality (sink, thread->quality + 1, "overload", cost, budget);
+    } else if (cost * 100 < budget * QUALITY_HEADROOM_PERCENT) {
+        thread->overload_frames = 0;
+        if (++thread->headroom_frames < thread->upgrade_frames ||
+            thread->quality == GST_GLES_QUALITY_FULL)
+            return;
+
+        gl_set_quality (sink, thread->quality - 1, "headroom", cost, budget);
+        thread->frames_since_upgrade = 0;
+    } else {
+        thread->overload_frames = 0;
+        thread->headroom_frames = 0;
+    }
+}
+
+/* Statistics */
+static GstStructure *
+gst_gles_sink_get_stats (GstGLESSink *sink)
+{
+    GstStructure *s = gst_gles_stats_get_structure (&sink->stats);
+
+#if GST_CHECK_VERSION(1, 4, 0)
+    {
+        /* buffers the base class dropped never reached us */
+        GstStructure *base = gst_base_sink_get_stats (GST_BASE_SINK (sink));
+        guint64 base_dropped = 0;
+        guint64 dropped = 0;
+
+        gst_structure_get_uint64 (base, "dropped", &base_dropped);
+        gst_structure_get_uint64 (s, "dropped", &dropped);
+        gst_structure_set (s, "dropped", G_TYPE_UINT64,
+                           dropped + base_dropped, NULL);
+        gst_structure_free (base);
     }
+#endif
 
-    XLockDisplay (sink->x11.display);
-    root = DefaultRootWindow (sink->x11.display);
-    swa.event_mask =
-            StructureNotifyMask | ExposureMask | VisibilityChangeMask;
+    gst_structure_set (s, "queue-depth", G_TYPE_UINT,
+                       sink->gl_thread.buf ? 1 : 0, NULL);
 
-    if (!sink->x11.window) {
-        sink->x11.window = XCreateWindow (
-                    sink->x11.display, root,
-                    0, 0, width, height, 0,
-                    CopyFromParent, InputOutput,
-                    CopyFromParent, CWEventMask,
-                    &swa);
+    if (sink->gl_thread.startup_done) {
+        GstStructure *startup = gst_gles_sink_get_startup (sink);
 
-        XSetWindowBackgroundPixmap (sink->x11.display, sink->x11.window,
-                                    None);
+        gst_structure_set (s, "startup", GST_TYPE_STRUCTURE, startup, NULL);
+        gst_structure_free (startup);
+    }
+
+    return s;
+}
+
+static void
+gl_update_stats (GstGLESSink *sink, GstClockTime draw_start)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstClockTime now = thread->gles.swap_end;
+#if GST_CHECK_VERSION(1, 0, 0)
+    gsize frame_size = GST_VIDEO_INFO_SIZE (&sink->info);
+#else
+    gsize frame_size = GST_VIDEO_SINK_WIDTH (sink) *
+                       GST_VIDEO_SINK_HEIGHT (sink) * 3 / 2;
+#endif
 
-        hints.input = True;
-        hints.flags = InputHint;
-        XSetWMHints(sink->x11.display, sink->x11.window, &hints);
+    gst_gles_stats_frame_rendered (&sink->stats, now - draw_start, now,
+                                   frame_size,
+                                   thread->gles.timer.cpu[STAGE_UPLOAD]);
 
-        XMapWindow (sink->x11.display, sink->x11.window);
-        XStoreName (sink->x11.display, sink->x11.window, "GLESSink");
-    } else {
-        guint border, depth;
-        int x, y;
-        /* change event mask, so we get resize notifications */
-        XSelectInput (sink->x11.display, sink->x11.window,
-                      ExposureMask | StructureNotifyMask |
-                      PointerMotionMask | KeyPressMask |
-                      KeyReleaseMask);
-
-        /* retrieve the current window geometry */
-        XGetGeometry (sink->x11.display, sink->x11.window, &root,
-                      &x, &y, (uint*)&sink->x11.width, (uint*)&sink->x11.height,
-                      &border, &depth);
-    }
+    if (!sink->stats_interval)
+        return;
 
-    XUnlockDisplay (sink->x11.display);
+    if (GST_CLOCK_TIME_IS_VALID (thread->last_stats) &&
+        now - thread->last_stats < sink->stats_interval * GST_MSECOND)
+        return;
 
-    return 0;
+    thread->last_stats = now;
+    gst_element_post_message (GST_ELEMENT (sink),
+            gst_message_new_element (GST_OBJECT (sink),
+                                     gst_gles_sink_get_stats (sink)));
 }
 
+/* Tracing */
 static void
-x11_close (GstGLESSink *sink)
+gl_trace_frame (GstGLESSink *sink)
 {
-    if (sink->x11.display) {
-        XLockDisplay (sink->x11.display);
-
-        /* only destroy the window if we created it, windows
-          owned by the application stay untouched */
-        if (!sink->x11.external_window) {
-            XDestroyWindow (sink->x11.display, sink->x11.window);
-            sink->x11.window = 0;
-        } else
-            XSelectInput (sink->x11.display, sink->x11.window, 0);
-
-        XSync (sink->x11.display, FALSE);
-        XUnlockDisplay (sink->x11.display);
-        XCloseDisplay(sink->x11.display);
-        sink->x11.display = NULL;
-    }
+    GstGLESTimer *timer = &sink->gl_thread.gles.timer;
+    guint i;
+
+    if (!gst_gles_trace_enabled (&sink->trace))
+        return;
+
+    for (i = 0; i < STAGE_COUNT; i++)
+        gst_gles_trace_stage (&sink->trace, GST_ELEMENT (sink),
+                              gl_timer_stage_name (i), timer->start[i],
+                              timer->cpu[i]);
 }
 
+/* called once the first frame was swapped */
 static void
-x11_handle_events (gpointer data)
+gl_report_startup (GstGLESSink *sink, GstClockTime draw_start)
 {
-    GstGLESSink *sink = GST_GLES_SINK (data);
+    GstGLESThread *thread = &sink->gl_thread;
+    GstClockTime swap_end = thread->gles.swap_end;
 
-    XLockDisplay (sink->x11.display);
-    while (XPending (sink->x11.display)) {
-        XEvent  xev;
-        XNextEvent(sink->x11.display, &xev);
-
-        switch (xev.type) {
-        case ConfigureRequest:
-            g_print("XConfigure* Request\n");
-        case ConfigureNotify:
-            GST_DEBUG_OBJECT(sink, "XConfigure* Event: wxh: %dx%d",
-                             xev.xconfigure.width,
-                             xev.xconfigure.height);
-            g_print("XConfigure* Event: wxh: %dx%d\n",
-                             xev.xconfigure.width,
-                             xev.xconfigure.height);
-            sink->x11.width = xev.xconfigure.width;
-            sink->x11.height = xev.xconfigure.height;
-
-            gl_draw_onscreen (sink);
-            break;
-        default:
-            break;
-        }
-    }
-    XUnlockDisplay (sink->x11.display);
+    thread->startup[GST_GLES_STARTUP_FIRST_FRAME] = swap_end - draw_start;
+    thread->startup_total = swap_end - thread->startup_begin;
+    thread->startup_done = TRUE;
+
+    GST_INFO_OBJECT (sink, "First frame after %" GST_TIME_FORMAT,
+                     GST_TIME_ARGS (thread->startup_total));
 
+    gst_element_post_message (GST_ELEMENT (sink),
+            gst_message_new_element (GST_OBJECT (sink),
+                                     gst_gles_sink_get_startup (sink)));
 }
 
 static gboolean
@@ -684,11 +1610,18 @@ gl_thread_init (GstGLESSink *sink)
     GstGLESThread *thread = &sink->gl_thread;
     GError *error = NULL;
 
+    thread->running = FALSE;
+    thread->init_done = FALSE;
+    thread->stopping = FALSE;
+    thread->parked = FALSE;
+    thread->gles.pool = gst_gles_pool_ref (sink->pool);
     thread->handle = g_thread_try_new ("gl_thread", gl_thread_proc, sink, &error);
     if (!thread->handle) {
         GST_ERROR_OBJECT (sink, "Can't create render-thread: %s",
                           error ? error->message : "(unknown)");
         g_clear_error (&error);
+        gst_gles_pool_unref (thread->gles.pool);
+        thread->gles.pool = NULL;
         return FALSE;
     }
     return TRUE;
@@ -697,16 +1630,101 @@ gl_thread_init (GstGLESSink *sink)
 static void
 gl_thread_stop (GstGLESSink *sink)
 {
-    if (sink->gl_thread.running) {
-        sink->gl_thread.running = FALSE;
-        g_mutex_lock (&sink->gl_thread.data_lock);
-        sink->gl_thread.buf = NULL;
+    GstGLESThread *thread = &sink->gl_thread;
+
+    if (!thread->handle)
+        return;
+
+    gl_pacing_unschedule (sink);
+    g_mutex_lock (&thread->data_lock);
+    /* both under the lock, so a thread still setting up its context
+     * can't set running again and never starts */
+    thread->running = FALSE;
+    thread->stopping = TRUE;
+    thread->buf = NULL;
+
+    g_cond_signal (&thread->data_signal);
+    g_mutex_unlock (&thread->data_lock);
+
+    g_thread_join (thread->handle);
+    thread->handle = NULL;
+}
 
-        g_cond_signal (&sink->gl_thread.data_signal);
-        g_mutex_unlock (&sink->gl_thread.data_lock);
+/* lets the thread of a stopped sink idle with its context for
+ * context_timeout ms, returns FALSE if there is no context to keep */
+static gboolean
+gl_thread_park (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    gboolean parked;
 
-        g_thread_join(sink->gl_thread.handle);
+    gl_pacing_unschedule (sink);
+    g_mutex_lock (&thread->data_lock);
+    parked = thread->handle && thread->running;
+    if (parked) {
+        thread->buf = NULL;
+        thread->parked = TRUE;
+        thread->park_deadline = g_get_monotonic_time () +
+                (gint64) sink->context_timeout * G_TIME_SPAN_MILLISECOND;
+        g_cond_signal (&thread->data_signal);
     }
+    g_mutex_unlock (&thread->data_lock);
+
+    return parked;
+}
+
+/* takes over the context of a parked thread, returns FALSE if there is
+ * none, e.g. because the idle timeout expired */
+static gboolean
+gl_thread_unpark (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    gboolean reused;
+
+    if (!thread->handle)
+        return FALSE;
+
+    g_mutex_lock (&thread->data_lock);
+    /* a context from another pool can't be shared with its users */
+    reused = thread->parked && thread->running &&
+             thread->gles.pool == sink->pool;
+    thread->parked = FALSE;
+    g_mutex_unlock (&thread->data_lock);
+
+    /* collect a thread that already gave up its context */
+    if (!reused)
+        gl_thread_stop (sink);
+    else
+        GST_DEBUG_OBJECT (sink, "Reuse GL context");
+
+    return reused;
+}
+
+/* blocks until the thread started in gst_gles_sink_start set up its
+ * context, returns FALSE if that failed */
+static gboolean
+gl_thread_wait_init (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+
+    g_mutex_lock (&thread->render_lock);
+    while (!thread->init_done)
+        g_cond_wait (&thread->render_signal, &thread->render_lock);
+    g_mutex_unlock (&thread->render_lock);
+
+    return thread->running;
+}
+
+/* blocks until the gl thread is done with the buffer handed to it */
+static void
+gl_thread_wait_render (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+
+    g_mutex_lock (&thread->render_lock);
+    while (!thread->render_done && thread->running)
+        g_cond_wait (&thread->render_signal, &thread->render_lock);
+    g_mutex_unlock (&thread->render_lock);
 }
 
 /* gl thread main function */
@@ -715,37 +1733,103 @@ gl_thread_proc (gpointer data)
 {
     GstGLESSink *sink = GST_GLES_SINK (data);
     GstGLESThread *thread = &sink->gl_thread;
+    gboolean ready;
 
-    GST_DEBUG_OBJECT(sink, "Init GL context (no timedwait)");
-    thread->running = setup_gl_context (sink) == 0;
+    GST_DEBUG_OBJECT(sink, "Init GL context");
+    ready = setup_gl_context (sink) == 0;
+
+    g_mutex_lock (&thread->data_lock);
+    thread->running = ready && !thread->stopping;
+    g_mutex_unlock (&thread->data_lock);
 
     GST_DEBUG_OBJECT(sink, "Init GL context done, send signal");
-    /* signal gst_gles_sink_render that we are done */
+    /* signal gst_gles_sink_preroll that we are done */
     g_mutex_lock (&thread->render_lock);
-    g_cond_signal (&thread->render_signal);
+    thread->init_done = TRUE;
+    g_cond_broadcast (&thread->render_signal);
     g_mutex_unlock (&thread->render_lock);
 
     while (thread->running) {
+        GstClockTime wait_start;
+
         x11_handle_events (sink);
 
         g_mutex_lock (&thread->data_lock);
         /* wait till gst_gles_sink_render has some data for us */
+        wait_start = gst_util_get_timestamp ();
         while (!thread->buf && thread->running) {
-            g_cond_wait (&thread->data_signal, &thread->data_lock);
+            if (!thread->parked) {
+                g_cond_wait (&thread->data_signal, &thread->data_lock);
+            } else if (!g_cond_wait_until (&thread->data_signal,
+                                           &thread->data_lock,
+                                           thread->park_deadline) &&
+                       thread->parked) {
+                GST_DEBUG_OBJECT (sink, "Idle timeout, close GL context");
+                thread->running = FALSE;
+            }
         }
+        gst_gles_trace_stage (&sink->trace, GST_ELEMENT (sink), "wait",
+                              wait_start,
+                              gst_util_get_timestamp () - wait_start);
 
         if (thread->buf) {
             if (!thread->gles.initialized) {
+                GstClockTime t = gst_util_get_timestamp ();
+
                 /* generate the framebuffer object */
                 gl_gen_framebuffer (sink);
                 thread->gles.initialized = TRUE;
+                gl_startup_mark (sink, GST_GLES_STARTUP_FRAMEBUFFER, &t);
+            } else if (thread->gles.frame_width !=
+                       GST_VIDEO_SINK_WIDTH (sink) ||
+                       thread->gles.frame_height !=
+                       GST_VIDEO_SINK_HEIGHT (sink) ||
+                       thread->gles.grid.format != sink->grid_format) {
+                GST_DEBUG_OBJECT (sink, "Resize textures to %dx%d",
+                                  GST_VIDEO_SINK_WIDTH (sink),
+                                  GST_VIDEO_SINK_HEIGHT (sink));
+                gl_alloc_frame_textures (sink);
+            } else if (memcmp (&thread->gles.color, &sink->color,
+                               sizeof (GstGLESColor)) != 0) {
+                gl_update_yuv_shaders (sink);
             }
 
-            XLockDisplay (sink->x11.display);
-            gl_draw_fbo (sink, thread->buf);
-            gl_draw_onscreen (sink);
+            if (sink->swap_interval != thread->gles.requested_interval)
+                egl_set_swap_interval (sink);
+
+            if (sink->pacing && !gl_pacing_wait (sink)) {
+                GST_DEBUG_OBJECT (sink, "Flushing, skip buffer");
+            } else {
+                GstClockTime draw_start = gst_util_get_timestamp ();
+
+                gst_gles_window_lock (&sink->window);
+                gl_timer_begin_frame (&thread->gles.timer);
+                gl_draw_fbo (sink, thread->buf);
+                gl_draw_onscreen (sink);
+                gl_timer_end_frame (&thread->gles.timer);
+                gst_gles_window_unlock (&sink->window);
+
+                if (sink->report_timings) {
+                    GstStructure *s;
+
+                    s = gl_timer_get_structure (&thread->gles.timer);
+                    gst_structure_set (s, "lock-wait", G_TYPE_UINT64,
+                                       sink->window.lock_wait, NULL);
+                    gst_element_post_message (GST_ELEMENT (sink),
+                            gst_message_new_element (GST_OBJECT (sink), s));
+                }
+
+                gl_pacing_update (sink, draw_start);
+                gl_update_latency (sink, draw_start);
+                gl_update_qos (sink);
+                gl_update_quality (sink, draw_start);
+                gl_update_stats (sink, draw_start);
+                gl_trace_frame (sink);
+
+                if (!thread->startup_done)
+                    gl_report_startup (sink, draw_start);
+            }
             thread->buf = NULL;
-            XUnlockDisplay (sink->x11.display);
 	    thread->render_done = TRUE;
         }
 
@@ -759,18 +1843,85 @@ gl_thread_proc (gpointer data)
 
     egl_close(sink);
     x11_close(sink);
+
+    gst_gles_pool_unref (thread->gles.pool);
+    thread->gles.pool = NULL;
     return 0;
 }
 
+/* compiles every program the stream may need. All of them are begun
+ * before any is finished, so a driver compiling in parallel can overlap
+ * them. */
+static gint
+gl_init_shaders (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    GstGLESContext *gles = &thread->gles;
+    GstGLESShader *shaders[] = {
+        &gles->deinterlace,
+        &gles->convert,
+        &gles->scale
+    };
+    const GstGLESShaderTypes types[] = {
+        SHADER_DEINT_LINEAR,
+        SHADER_YUV_RGB,
+        SHADER_COPY
+    };
+    gboolean from_binary[G_N_ELEMENTS (shaders)];
+    GstClockTime t = gst_util_get_timestamp ();
+    GstClockTime read_time = 0;
+    GBytes *binary;
+    GLenum format;
+    gint ret = 0;
+    guint i;
+
+    gl_shader_parallel_compile (GST_ELEMENT (sink));
+
+    for (i = 0; i < G_N_ELEMENTS (shaders) && ret == 0; i++) {
+        /* another instance in the pool may have linked it already */
+        binary = gst_gles_pool_get_binary (gles->pool, types[i], &format);
+        ret = -ENOENT;
+        if (binary) {
+            ret = gl_begin_shader_binary (GST_ELEMENT (sink), shaders[i],
+                                          format, binary);
+            g_bytes_unref (binary);
+        }
+
+        from_binary[i] = ret == 0;
+        if (!from_binary[i])
+            ret = gl_begin_shader (GST_ELEMENT (sink), shaders[i], types[i]);
+        read_time += shaders[i]->read_time;
+    }
+    for (i = 0; i < G_N_ELEMENTS (shaders) && ret == 0; i++) {
+        ret = gl_finish_shader (GST_ELEMENT (sink), shaders[i]);
+        if (ret < 0 || from_binary[i])
+            continue;
+
+        binary = gl_get_shader_binary (shaders[i], &format);
+        if (binary) {
+            gst_gles_pool_set_binary (gles->pool, types[i], format, binary);
+            g_bytes_unref (binary);
+        }
+    }
+
+    thread->startup[GST_GLES_STARTUP_SHADER_READ] += read_time;
+    gl_startup_mark (sink, GST_GLES_STARTUP_SHADER_COMPILE, &t);
+    thread->startup[GST_GLES_STARTUP_SHADER_COMPILE] -= read_time;
+
+    return ret;
+}
+
 static gint
 setup_gl_context (GstGLESSink *sink)
 {
     GstGLESContext *gles = &sink->gl_thread.gles;
+    const gchar *version;
+    const gchar *extensions;
     gint ret;
 
-    sink->x11.width = 720;
-    sink->x11.height = 576;
-    if (x11_init (sink, sink->x11.width, sink->x11.height) < 0) {
+    sink->window.width = sink->window_width;
+    sink->window.height = sink->window_height;
+    if (x11_init (sink, sink->window.width, sink->window.height) < 0) {
         GST_ERROR_OBJECT (sink, "X11 init failed, abort");
         return -ENOMEM;
     }
@@ -781,39 +1932,50 @@ setup_gl_context (GstGLESSink *sink)
         return -ENOMEM;
     }
 
-    ret = gl_init_shader (GST_ELEMENT (sink), &gles->deinterlace,
-                          SHADER_DEINT_LINEAR);
-    if (ret < 0) {
-        GST_ERROR_OBJECT (sink, "Could not initialize shader: %d", ret);
-        egl_close (sink);
-        x11_close (sink);
-        return -ENOMEM;
-    }
-    gles->y_tex.loc = glGetUniformLocation(gles->deinterlace.program,
-                                           "s_ytex");
-    gles->u_tex.loc = glGetUniformLocation(gles->deinterlace.program,
-                                           "s_utex");
-    gles->v_tex.loc = glGetUniformLocation(gles->deinterlace.program,
-                                           "s_vtex");
-
-    ret = gl_init_shader (GST_ELEMENT (sink), &gles->scale, SHADER_COPY);
+    gl_timer_init (GST_ELEMENT (sink), &gles->timer);
+
+    ret = gl_init_shaders (sink);
     if (ret < 0) {
         GST_ERROR_OBJECT (sink, "Could not initialize shader: %d", ret);
         egl_close (sink);
         x11_close (sink);
         return -ENOMEM;
     }
+    gl_init_yuv_samplers (&gles->deinterlace);
+    gl_init_yuv_samplers (&gles->convert);
+
+    if (gles->shared)
+        gst_gles_pool_get_quad (gles->pool, &gles->quad_vbo,
+                                &gles->quad_ibo);
+    else
+        gl_create_quad (&gles->quad_vbo, &gles->quad_ibo);
     gles->rgb_tex.loc = glGetUniformLocation(gles->scale.program, "s_tex");
-    gl_init_textures (sink);
+    glUseProgram (gles->scale.program);
+    glUniform1i (gles->rgb_tex.loc, 3);
+    gles->line_height_loc = glGetUniformLocation (gles->deinterlace.program,
+                                                  "line_height");
+    glGetIntegerv (GL_MAX_TEXTURE_SIZE, &gles->max_texture_size);
+
+    /* GLES 2 only mipmaps power of two textures */
+    version = (const gchar *) glGetString (GL_VERSION);
+    extensions = (const gchar *) glGetString (GL_EXTENSIONS);
+    gles->npot_mipmaps = (version &&
+                          g_str_has_prefix (version, "OpenGL ES 3")) ||
+            (extensions && strstr (extensions, "GL_OES_texture_npot"));
+
+    /* lets the tests split frames on GLs with large textures */
+    if (sink->max_texture_size >= 2 * (GRID_BORDER + 1))
+        gles->max_texture_size = MIN (gles->max_texture_size,
+                                      sink->max_texture_size);
 
     /* finally announce the window handle to controling app */
-    if (!sink->x11.external_window)
+    if (sink->window.window && !sink->window.external_window)
 #if GST_CHECK_VERSION(1, 0, 0)
         gst_video_overlay_got_window_handle (GST_VIDEO_OVERLAY (sink),
-                                         sink->x11.window);
+                                         sink->window.window);
 #else
         gst_x_overlay_got_window_handle (GST_X_OVERLAY (sink),
-                                         sink->x11.window);
+                                         sink->window.window);
 #endif
     return 0;
 }
@@ -880,12 +2042,128 @@ gst_gles_sink_class_init (GstGLESSinkClass * klass)
 	"first frame is drawn, drop n frames.", 0, G_MAXUINT, 0,
 	  G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_SWAP_INTERVAL,
+      g_param_spec_int ("swap_interval", "Swap interval", "Number of "
+        "vertical blanks to wait for on each buffer swap, 0 disables vsync, "
+        "-1 keeps the driver default.", -1, G_MAXINT, DEFAULT_SWAP_INTERVAL,
+	  G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low_latency", "Low latency swap", "Use buffer "
+        "age or preserved swap behaviour where EGL supports it. Takes effect "
+        "when the EGL surface is created.", FALSE,
+	  G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SWAP_MODE,
+      g_param_spec_string ("swap_mode", "Swap mode", "Swap interval and "
+        "back buffer behaviour actually selected for the EGL surface.",
+        "none", G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_PACING,
+      g_param_spec_boolean ("pacing", "Frame pacing", "Schedule rendering "
+        "so each frame is presented on the first vblank after its "
+        "timestamp and post a GstGLESSinkPresented message per frame.",
+        FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_ADAPTIVE_QUALITY,
+      g_param_spec_boolean ("adaptive_quality", "Adaptive quality", "Fall "
+        "back to bilinear scaling, drop deinterlacing and shrink the "
+        "intermediate framebuffer while "
+        "rendering does not fit the frame budget, restore it once there is "
+        "headroom again. Posts a GstGLESSinkQuality message on each change.",
+        FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_QUALITY,
+      g_param_spec_string ("quality", "Quality", "Current quality level "
+        "selected by the adaptive quality governor.",
+        quality_names[GST_GLES_QUALITY_FULL], G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_REPORT_TIMINGS,
+      g_param_spec_boolean ("report_timings", "Report timings", "Post a "
+        "GstGLESSinkTimings message with the cpu and, where timer queries "
+        "are available, gpu time of each render stage after every frame, "
+        "and the time spent waiting for the display lock.",
+        FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics", "Rendering statistics: "
+        "frames rendered, dropped and late, average/p95/p99 upload to "
+        "present latency, achieved fps, upload bandwidth and queue depth.",
+        GST_TYPE_STRUCTURE, G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats_interval", "Statistics interval", "Post the "
+        "statistics as GstGLESSinkStats message every n milliseconds while "
+        "rendering, 0 disables the message.", 0, G_MAXUINT, 0,
+        G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_TRACE_FILE,
+      g_param_spec_string ("trace_file", "Trace file", "Write the render "
+        "stages as chrome trace-event JSON to this file, taking effect on "
+        "the next start.", NULL, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_CONTEXT_TIMEOUT,
+      g_param_spec_uint ("context_timeout", "Context timeout", "Keep the "
+        "window and GL context of a stopped sink for n milliseconds, so a "
+        "restart within that time reuses them. 0 releases them on stop.",
+        0, G_MAXUINT, DEFAULT_CONTEXT_TIMEOUT, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_BACKEND,
+      g_param_spec_enum ("backend", "Backend", "Window system to draw "
+        "with, pbuffer and surfaceless draw offscreen without a window.",
+        GST_TYPE_GLES_BACKEND, DEFAULT_BACKEND, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_DEINTERLACE,
+      g_param_spec_boolean ("deinterlace", "Deinterlace", "Deinterlace "
+        "the video in the framebuffer pass.", TRUE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_WINDOW_WIDTH,
+      g_param_spec_int ("window_width", "Window width", "Width of the "
+        "window or offscreen surface created by the sink.", 1, G_MAXINT,
+        DEFAULT_WINDOW_WIDTH, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_WINDOW_HEIGHT,
+      g_param_spec_int ("window_height", "Window height", "Height of the "
+        "window or offscreen surface created by the sink.", 1, G_MAXINT,
+        DEFAULT_WINDOW_HEIGHT, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_READBACK,
+      g_param_spec_boolean ("readback", "Readback", "Read every presented "
+        "frame back and post it as RGBA buffer in a GstGLESSinkReadback "
+        "element message. Slow, meant for tests.", FALSE,
+        G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_TEXTURE_SIZE,
+      g_param_spec_int ("max_texture_size", "Max texture size", "Split "
+        "frames into textures no larger than this, 0 for the limit of the "
+        "GL. Lets tests cover the grid on GLs with large textures, takes "
+        "effect when the GL context is set up.", 0, G_MAXINT, 0,
+        G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SCALING,
+      g_param_spec_enum ("scaling", "Scaling", "Filter the video is "
+        "scaled to the window with. Downscales by more than half use "
+        "mipmaps instead where the GL supports them.",
+        GST_TYPE_GLES_SCALING, DEFAULT_SCALING, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PACKED_UPLOAD,
+      g_param_spec_boolean ("packed_upload", "Packed upload", "Upload 8 "
+        "bit I420 frames whose planes follow each other without padding "
+        "as one texture instead of one per plane. Applies from the next "
+        "caps on.", TRUE, G_PARAM_READWRITE));
+
   /* initialise virtual methods */
   basesink_class->start = GST_DEBUG_FUNCPTR (gst_gles_sink_start);
   basesink_class->stop = GST_DEBUG_FUNCPTR (gst_gles_sink_stop);
   basesink_class->render = GST_DEBUG_FUNCPTR (gst_gles_sink_render);
   basesink_class->preroll = GST_DEBUG_FUNCPTR (gst_gles_sink_preroll);
   basesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_gles_sink_set_caps);
+  basesink_class->unlock = GST_DEBUG_FUNCPTR (gst_gles_sink_unlock);
+  basesink_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_gles_sink_unlock_stop);
+#if GST_CHECK_VERSION(1, 2, 0)
+  basesink_class->query = GST_DEBUG_FUNCPTR (gst_gles_sink_query);
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_gles_sink_set_context);
+#endif
 
 #if GST_CHECK_VERSION(1, 0, 0)
   gst_element_class_set_details_simple(element_class,
@@ -916,8 +2194,30 @@ gst_gles_sink_init (GstGLESSink * sink,
     Status ret;
 
     sink->silent = FALSE;
+    sink->swap_interval = DEFAULT_SWAP_INTERVAL;
+    sink->low_latency = FALSE;
+    sink->pacing = FALSE;
+    sink->adaptive_quality = FALSE;
+    sink->report_timings = FALSE;
+    sink->stats_interval = 0;
+    sink->context_timeout = DEFAULT_CONTEXT_TIMEOUT;
+    sink->backend = DEFAULT_BACKEND;
+    sink->deinterlace = TRUE;
+    sink->window_width = DEFAULT_WINDOW_WIDTH;
+    sink->window_height = DEFAULT_WINDOW_HEIGHT;
+    sink->readback = FALSE;
+    sink->max_texture_size = 0;
+    sink->scaling = DEFAULT_SCALING;
+    sink->packed_upload = TRUE;
     sink->gl_thread.gles.initialized = FALSE;
 
+    gst_gles_stats_init (&sink->stats);
+    gst_gles_trace_init (&sink->trace);
+
+    thread->target = GST_CLOCK_TIME_NONE;
+    thread->last_vblank = GST_CLOCK_TIME_NONE;
+    thread->vblank_period = DEFAULT_REFRESH_PERIOD;
+
     g_mutex_init(&thread->data_lock);
     g_mutex_init(&thread->render_lock);
     g_cond_init(&thread->data_signal);
@@ -928,8 +2228,22 @@ gst_gles_sink_init (GstGLESSink * sink,
         GST_ERROR_OBJECT(sink, "XInitThreads failed");
     }
 
-    gst_base_sink_set_max_lateness (GST_BASE_SINK (sink), 20 * GST_MSECOND);
+    sink->frame_duration = GST_CLOCK_TIME_NONE;
+    sink->max_lateness = DEFAULT_MAX_LATENESS;
+    gst_base_sink_set_max_lateness (GST_BASE_SINK (sink), sink->max_lateness);
+    sink->render_delay = 0;
+    sink->user_render_delay = 0;
     gst_base_sink_set_qos_enabled(GST_BASE_SINK (sink), TRUE);
+
+    thread->qos_sent = FALSE;
+#if GST_CHECK_VERSION(1, 0, 0)
+    gst_pad_add_probe (GST_BASE_SINK_PAD (sink),
+                       GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+                       gst_gles_sink_qos_probe, sink, NULL);
+#else
+    gst_pad_add_event_probe (GST_BASE_SINK_PAD (sink),
+                             G_CALLBACK (gst_gles_sink_qos_probe), sink);
+#endif
 }
 
 static void
@@ -957,6 +2271,55 @@ gst_gles_sink_set_property (GObject * object, guint prop_id,
     case PROP_DROP_FIRST:
       filter->drop_first = g_value_get_uint (value);
       break;
+    case PROP_SWAP_INTERVAL:
+      filter->swap_interval = g_value_get_int (value);
+      break;
+    case PROP_LOW_LATENCY:
+      filter->low_latency = g_value_get_boolean (value);
+      break;
+    case PROP_PACING:
+      filter->pacing = g_value_get_boolean (value);
+      break;
+    case PROP_ADAPTIVE_QUALITY:
+      filter->adaptive_quality = g_value_get_boolean (value);
+      break;
+    case PROP_REPORT_TIMINGS:
+      filter->report_timings = g_value_get_boolean (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      filter->stats_interval = g_value_get_uint (value);
+      break;
+    case PROP_TRACE_FILE:
+      g_free (filter->trace_file);
+      filter->trace_file = g_value_dup_string (value);
+      break;
+    case PROP_CONTEXT_TIMEOUT:
+      filter->context_timeout = g_value_get_uint (value);
+      break;
+    case PROP_BACKEND:
+      filter->backend = g_value_get_enum (value);
+      break;
+    case PROP_DEINTERLACE:
+      filter->deinterlace = g_value_get_boolean (value);
+      break;
+    case PROP_WINDOW_WIDTH:
+      filter->window_width = g_value_get_int (value);
+      break;
+    case PROP_WINDOW_HEIGHT:
+      filter->window_height = g_value_get_int (value);
+      break;
+    case PROP_READBACK:
+      filter->readback = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_TEXTURE_SIZE:
+      filter->max_texture_size = g_value_get_int (value);
+      break;
+    case PROP_SCALING:
+      filter->scaling = g_value_get_enum (value);
+      break;
+    case PROP_PACKED_UPLOAD:
+      filter->packed_upload = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -988,6 +2351,63 @@ gst_gles_sink_get_property (GObject * object, guint prop_id,
     case PROP_DROP_FIRST:
       g_value_set_uint (value, filter->drop_first);
       break;
+    case PROP_SWAP_INTERVAL:
+      g_value_set_int (value, filter->swap_interval);
+      break;
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, filter->low_latency);
+      break;
+    case PROP_SWAP_MODE:
+      g_value_take_string (value, egl_describe_swap_mode (filter));
+      break;
+    case PROP_PACING:
+      g_value_set_boolean (value, filter->pacing);
+      break;
+    case PROP_ADAPTIVE_QUALITY:
+      g_value_set_boolean (value, filter->adaptive_quality);
+      break;
+    case PROP_QUALITY:
+      g_value_set_string (value, quality_names[filter->gl_thread.quality]);
+      break;
+    case PROP_REPORT_TIMINGS:
+      g_value_set_boolean (value, filter->report_timings);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_gles_sink_get_stats (filter));
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, filter->stats_interval);
+      break;
+    case PROP_TRACE_FILE:
+      g_value_set_string (value, filter->trace_file);
+      break;
+    case PROP_CONTEXT_TIMEOUT:
+      g_value_set_uint (value, filter->context_timeout);
+      break;
+    case PROP_BACKEND:
+      g_value_set_enum (value, filter->backend);
+      break;
+    case PROP_DEINTERLACE:
+      g_value_set_boolean (value, filter->deinterlace);
+      break;
+    case PROP_WINDOW_WIDTH:
+      g_value_set_int (value, filter->window_width);
+      break;
+    case PROP_WINDOW_HEIGHT:
+      g_value_set_int (value, filter->window_height);
+      break;
+    case PROP_READBACK:
+      g_value_set_boolean (value, filter->readback);
+      break;
+    case PROP_MAX_TEXTURE_SIZE:
+      g_value_set_int (value, filter->max_texture_size);
+      break;
+    case PROP_SCALING:
+      g_value_set_enum (value, filter->scaling);
+      break;
+    case PROP_PACKED_UPLOAD:
+      g_value_set_boolean (value, filter->packed_upload);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -996,10 +2416,108 @@ gst_gles_sink_get_property (GObject * object, guint prop_id,
 
 /* GstElement vmethod implementations */
 
+/* takes the pool the application or a neighbour shares, before falling
+ * back to the process-wide one */
+static gboolean
+gst_gles_sink_find_pool (GstGLESSink *sink)
+{
+    GstGLESThread *thread = &sink->gl_thread;
+    gboolean created = FALSE;
+#if GST_CHECK_VERSION(1, 2, 0)
+    GstContext *context;
+    GstQuery *query;
+
+    if (!sink->pool) {
+        query = gst_query_new_context (GST_GLES_POOL_CONTEXT_TYPE);
+        if (gst_pad_peer_query (GST_BASE_SINK_PAD (sink), query)) {
+            gst_query_parse_context (query, &context);
+            if (context)
+                gst_element_set_context (GST_ELEMENT (sink), context);
+        }
+        gst_query_unref (query);
+    }
+
+    /* the application may answer from its sync handler */
+    if (!sink->pool)
+        gst_element_post_message (GST_ELEMENT (sink),
+                gst_message_new_need_context (GST_OBJECT (sink),
+                                              GST_GLES_POOL_CONTEXT_TYPE));
+#endif
+    if (sink->pool)
+        return TRUE;
+
+    sink->pool = gst_gles_pool_get_default (sink->backend, &created);
+    if (!sink->pool)
+        return FALSE;
+
+    /* only the first user pays for opening the display */
+    if (created) {
+        thread->startup[GST_GLES_STARTUP_X11_OPEN] = sink->pool->open_time;
+        thread->startup[GST_GLES_STARTUP_EGL_INITIALIZE] =
+                sink->pool->initialize_time;
+    }
+
+#if GST_CHECK_VERSION(1, 2, 0)
+    context = gst_gles_pool_context_new (sink->pool);
+    gst_element_post_message (GST_ELEMENT (sink),
+            gst_message_new_have_context (GST_OBJECT (sink), context));
+#endif
+
+    return TRUE;
+}
+
 /* initialisation code */
 static gboolean
 gst_gles_sink_start (GstBaseSink *basesink)
 {
+    GstGLESSink *sink = GST_GLES_SINK (basesink);
+
+    sink->gl_thread.flushing = FALSE;
+    sink->gl_thread.last_vblank = GST_CLOCK_TIME_NONE;
+    sink->gl_thread.present_latency = 0;
+    sink->gl_thread.present_cost = 0;
+
+    sink->gl_thread.quality = GST_GLES_QUALITY_FULL;
+    sink->gl_thread.overload_frames = 0;
+    sink->gl_thread.headroom_frames = 0;
+    sink->gl_thread.upgrade_frames = QUALITY_UPGRADE_FRAMES;
+    sink->gl_thread.frames_since_upgrade = G_MAXUINT;
+
+    sink->gl_thread.last_stats = GST_CLOCK_TIME_NONE;
+    gst_gles_stats_reset (&sink->stats);
+
+    if (sink->trace_file &&
+        !gst_gles_trace_open (&sink->trace, sink->trace_file))
+        GST_WARNING_OBJECT (sink, "Could not open trace file %s",
+                            sink->trace_file);
+
+    sink->gl_thread.startup_begin = gst_util_get_timestamp ();
+    memset (sink->gl_thread.startup, 0, sizeof (sink->gl_thread.startup));
+    sink->gl_thread.startup_total = 0;
+    sink->gl_thread.startup_done = FALSE;
+
+    if (!gst_gles_sink_find_pool (sink)) {
+        GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE,
+                           ("Could not open display"), (NULL));
+        return FALSE;
+    }
+
+    /* give the application the opportunity to head in a
+       xwindow id to use as render target */
+#if GST_CHECK_VERSION(1, 0, 0)
+    gst_video_overlay_prepare_window_handle (GST_VIDEO_OVERLAY (sink));
+#else
+    gst_x_overlay_prepare_xwindow_id (GST_X_OVERLAY (sink));
+#endif
+
+    /* set up window, context and shaders while the pipeline prerolls,
+     * unless the previous run left them behind */
+    if (!gl_thread_unpark (sink) && !gl_thread_init (sink)) {
+        GST_ELEMENT_ERROR (sink, LIBRARY, INIT,
+                           ("Can't create render-thread"), (NULL));
+        return FALSE;
+    }
+
     return TRUE;
 }
 
@@ -1009,7 +2527,17 @@ gst_gles_sink_stop (GstBaseSink *basesink)
 {
     GstGLESSink *sink = GST_GLES_SINK (basesink);
 
-    gl_thread_stop (sink);
+    if (!sink->context_timeout || !gl_thread_park (sink))
+        gl_thread_stop (sink);
+    gst_gles_trace_close (&sink->trace);
+
+    /* a parked thread holds its own reference */
+    GST_OBJECT_LOCK (sink);
+    if (sink->pool) {
+        gst_gles_pool_unref (sink->pool);
+        sink->pool = NULL;
+    }
+    GST_OBJECT_UNLOCK (sink);
 
     GST_VIDEO_SINK_WIDTH (sink) = 0;
     GST_VIDEO_SINK_HEIGHT (sink)  = 0;
@@ -1017,6 +2545,25 @@ gst_gles_sink_stop (GstBaseSink *basesink)
     return TRUE;
 }
 
+#if GST_CHECK_VERSION(1, 0, 0)
+/* whether the planes of an I420 frame follow each other without any
+ * padding, so the frame can be uploaded as one texture */
+static gboolean
+gst_gles_sink_packed_layout (GstVideoInfo *info)
+{
+  gint width = GST_VIDEO_INFO_WIDTH (info);
+  gint height = GST_VIDEO_INFO_HEIGHT (info);
+
+  return height % 4 == 0 &&
+      GST_VIDEO_INFO_PLANE_STRIDE (info, 0) == width &&
+      GST_VIDEO_INFO_PLANE_STRIDE (info, 1) * 2 == width &&
+      GST_VIDEO_INFO_PLANE_STRIDE (info, 2) * 2 == width &&
+      GST_VIDEO_INFO_PLANE_OFFSET (info, 1) == width * height &&
+      GST_VIDEO_INFO_PLANE_OFFSET (info, 2) ==
+          GST_VIDEO_INFO_PLANE_OFFSET (info, 1) + width * height / 4;
+}
+#endif
+
 /* this function handles the link with other elements */
 static gboolean
 gst_gles_sink_set_caps (GstBaseSink *basesink, GstCaps *caps)
@@ -1027,6 +2574,8 @@ gst_gles_sink_set_caps (GstBaseSink *basesink, GstCaps *caps)
   guint display_par_d;
   gint par_n;
   gint par_d;
+  gint fps_n;
+  gint fps_d;
   gint w;
   gint h;
 
@@ -1039,10 +2588,28 @@ gst_gles_sink_set_caps (GstBaseSink *basesink, GstCaps *caps)
   }
 
   fmt = GST_VIDEO_INFO_FORMAT(&info);
+  switch (fmt) {
+    case GST_VIDEO_FORMAT_I420_10LE:
+      sink->grid_format = GRID_FORMAT_I420_10;
+      break;
+    case GST_VIDEO_FORMAT_P010_10LE:
+      sink->grid_format = GRID_FORMAT_P010;
+      break;
+    default:
+      g_assert ((fmt == GST_VIDEO_FORMAT_I420));
+      sink->grid_format = sink->packed_upload &&
+          gst_gles_sink_packed_layout (&info) ?
+          GRID_FORMAT_I420_PACKED : GRID_FORMAT_I420;
+      break;
+  }
+  sink->info = info;
+  gst_gles_color_from_caps (&sink->color, caps);
   w = info.width;
   h = info.height;
   par_n = info.par_n;
   par_d = info.par_d;
+  fps_n = info.fps_n;
+  fps_d = info.fps_d;
 #else
   if (!gst_video_format_parse_caps (caps, &fmt, &w, &h)) {
       GST_WARNING_OBJECT (sink, "pase_caps failed");
@@ -1054,8 +2621,16 @@ gst_gles_sink_set_caps (GstBaseSink *basesink, GstCaps *caps)
       GST_WARNING_OBJECT (sink, "no pixel aspect ratio");
       return FALSE;
   }
-#endif
+
+  if (!gst_video_parse_caps_framerate (caps, &fps_n, &fps_d)) {
+      fps_n = 0;
+      fps_d = 1;
+  }
   g_assert ((fmt == GST_VIDEO_FORMAT_I420));
+  /* the strides of the planes are rounded up to 4 bytes */
+  sink->grid_format = sink->packed_upload && w % 8 == 0 && h % 4 == 0 ?
+      GRID_FORMAT_I420_PACKED : GRID_FORMAT_I420;
+#endif
 
   sink->video_width = w;
   sink->video_height = h;
@@ -1077,59 +2652,86 @@ gst_gles_sink_set_caps (GstBaseSink *basesink, GstCaps *caps)
 
   sink->video_width = sink->video_width * par_n / par_d;
 
+  /* the frame budget, variable framerates don't have one */
+  if (fps_n > 0 && fps_d > 0)
+      sink->frame_duration = gst_util_uint64_scale_int (GST_SECOND, fps_d,
+                                                        fps_n);
+  else
+      sink->frame_duration = GST_CLOCK_TIME_NONE;
+  gst_gles_sink_update_max_lateness (sink);
+
   return TRUE;
 }
 
+static GstClockTime
+gst_gles_sink_get_running_time (GstGLESSink *sink, GstBuffer *buf)
+{
+    GstBaseSink *basesink = GST_BASE_SINK (sink);
+    GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+        return GST_CLOCK_TIME_NONE;
+
+    return gst_segment_to_running_time (&basesink->segment,
+                                        GST_FORMAT_TIME, timestamp);
+}
+
+/* clock time at which a buffer is supposed to be visible */
+static GstClockTime
+gst_gles_sink_get_target_time (GstGLESSink *sink, GstClockTime running_time)
+{
+    GstBaseSink *basesink = GST_BASE_SINK (sink);
+    GstClockTimeDiff offset;
+    GstClockTime target;
+
+    if (!GST_CLOCK_TIME_IS_VALID (running_time))
+        return GST_CLOCK_TIME_NONE;
+
+    target = running_time + gst_element_get_base_time (GST_ELEMENT (sink));
+    target += gst_base_sink_get_latency (basesink);
+
+    offset = gst_base_sink_get_ts_offset (basesink);
+    if (offset < 0 && (GstClockTime) -offset > target)
+        return 0;
+
+    return target + offset;
+}
+
 static GstFlowReturn
 gst_gles_sink_preroll (GstBaseSink * basesink, GstBuffer * buf)
 {
     GstGLESSink *sink = GST_GLES_SINK (basesink);
     GstGLESThread *thread = &sink->gl_thread;
 
-    if (!thread->running) {
-        /* give the application the opportunity to head in a
-           xwindow id to use as render target */
-#if GST_CHECK_VERSION(1, 0, 0)
-        gst_video_overlay_prepare_window_handle (GST_VIDEO_OVERLAY (sink));
-#else
-        gst_x_overlay_prepare_xwindow_id (GST_X_OVERLAY (sink));
-#endif
-
-        g_mutex_lock (&thread->render_lock);
-        if (!gl_thread_init (sink)) {
-            g_mutex_unlock (&thread->render_lock);
-            goto fail;
-        }
-        GST_DEBUG_OBJECT(sink, "Wait for init GL context");
-	if (!thread->running) {
-            g_cond_wait (&thread->render_signal, &thread->render_lock);
-            g_mutex_unlock (&thread->render_lock);
-	}
-        GST_DEBUG_OBJECT(sink, "Init completed");
-    }
+    /* the context is set up in the background since start, usually it
+     * is ready by the time the first buffer arrives */
+    GST_DEBUG_OBJECT(sink, "Wait for init GL context");
+    if (!gl_thread_wait_init (sink))
+        goto fail;
+    GST_DEBUG_OBJECT(sink, "Init completed");
 
     if (sink->dropped < sink->drop_first) {
         sink->dropped++;
+        gst_gles_stats_frame_dropped (&sink->stats);
         goto done;
     }
 
     g_mutex_lock (&thread->data_lock);
     thread->render_done = FALSE;
     thread->buf = buf;
+    /* the preroll buffer is shown right away */
+    thread->running_time = GST_CLOCK_TIME_NONE;
+    thread->target = GST_CLOCK_TIME_NONE;
     g_cond_signal (&thread->data_signal);
     g_mutex_unlock (&thread->data_lock);
 
-    if (!thread->render_done) {
-        g_mutex_lock (&thread->render_lock);
-        g_cond_wait (&thread->render_signal, &thread->render_lock);
-        g_mutex_unlock (&thread->render_lock);
-    }
+    gl_thread_wait_render (sink);
 
 done:
     return GST_FLOW_OK;
 fail:
-    GST_ELEMENT_ERROR (sink, LIBRARY, INIT, ("Can't create render-thread"),
-                       GST_ERROR_SYSTEM);
+    GST_ELEMENT_ERROR (sink, LIBRARY, INIT,
+                       ("Could not initialize GL context"), (NULL));
     return GST_FLOW_ERROR;
 }
 
@@ -1145,35 +2747,121 @@ gst_gles_sink_render (GstBaseSink *basesink, GstBuffer *buf)
 
     if (sink->dropped < sink->drop_first) {
         sink->dropped++;
+        gst_gles_stats_frame_dropped (&sink->stats);
         goto done;
     }
 
+    g_atomic_int_set (&thread->qos_sent, FALSE);
+
     g_mutex_lock (&thread->data_lock);
     thread->render_done = FALSE;
     thread->buf = buf;
+    thread->running_time = gst_gles_sink_get_running_time (sink, buf);
+    thread->target = gst_gles_sink_get_target_time (sink,
+                                                    thread->running_time);
     g_cond_signal (&thread->data_signal);
     g_mutex_unlock (&thread->data_lock);
 
-    if (!thread->render_done) {
-        g_mutex_lock (&thread->render_lock);
-        g_cond_wait (&thread->render_signal, &thread->render_lock);
-        g_mutex_unlock (&thread->render_lock);
-    }
+    gl_thread_wait_render (sink);
 
 done:
     stop = gst_util_get_timestamp();
     GST_DEBUG_OBJECT (basesink, "Render took %llu ms",
                         stop/GST_MSECOND - start/GST_MSECOND);
+    gst_gles_trace_stage (&sink->trace, GST_ELEMENT (sink), "render",
+                          start, stop - start);
 
     return GST_FLOW_OK;
 }
 
+#if GST_CHECK_VERSION(1, 2, 0)
+static void
+gst_gles_sink_set_context (GstElement *element, GstContext *context)
+{
+    GstGLESSink *sink = GST_GLES_SINK (element);
+    GstGLESPool *pool = gst_gles_pool_from_context (context);
+
+    if (pool && pool->backend->type != sink->backend) {
+        GST_DEBUG_OBJECT (sink, "Ignoring GLES pool %p of the %s backend",
+                          pool, pool->backend->name);
+        gst_gles_pool_unref (pool);
+        pool = NULL;
+    }
+
+    if (pool) {
+        GST_DEBUG_OBJECT (sink, "Using GLES pool %p", pool);
+        GST_OBJECT_LOCK (sink);
+        if (sink->pool)
+            gst_gles_pool_unref (sink->pool);
+        sink->pool = pool;
+        GST_OBJECT_UNLOCK (sink);
+    }
+
+    if (GST_ELEMENT_CLASS (gst_gles_sink_parent_class)->set_context)
+        GST_ELEMENT_CLASS (gst_gles_sink_parent_class)->set_context (element,
+                                                                     context);
+}
+
+static gboolean
+gst_gles_sink_query (GstBaseSink *basesink, GstQuery *query)
+{
+    GstGLESSink *sink = GST_GLES_SINK (basesink);
+    const gchar *type;
+    gboolean ret = FALSE;
+
+    if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT) {
+        gst_query_parse_context_type (query, &type);
+        if (g_str_equal (type, GST_GLES_POOL_CONTEXT_TYPE)) {
+            GST_OBJECT_LOCK (sink);
+            if (sink->pool) {
+                GstContext *context = gst_gles_pool_context_new (sink->pool);
+
+                gst_query_set_context (query, context);
+                gst_context_unref (context);
+                ret = TRUE;
+            }
+            GST_OBJECT_UNLOCK (sink);
+            if (ret)
+                return TRUE;
+        }
+    }
+
+    return GST_BASE_SINK_CLASS (gst_gles_sink_parent_class)->query (basesink,
+                                                                     query);
+}
+#endif
+
+static gboolean
+gst_gles_sink_unlock (GstBaseSink *basesink)
+{
+    gl_pacing_unschedule (GST_GLES_SINK (basesink));
+
+    return TRUE;
+}
+
+static gboolean
+gst_gles_sink_unlock_stop (GstBaseSink *basesink)
+{
+    GstGLESSink *sink = GST_GLES_SINK (basesink);
+
+    GST_OBJECT_LOCK (sink);
+    sink->gl_thread.flushing = FALSE;
+    GST_OBJECT_UNLOCK (sink);
+
+    return TRUE;
+}
+
 static void
 gst_gles_sink_finalize (GObject *gobject)
 {
     GstGLESSink *plugin = (GstGLESSink *)gobject;
 
     gl_thread_stop (plugin);
+    if (plugin->pool)
+        gst_gles_pool_unref (plugin->pool);
+    gst_gles_stats_clear (&plugin->stats);
+    gst_gles_trace_clear (&plugin->trace);
+    g_free (plugin->trace_file);
 }
 
 /* Overlay Interface implementation */
@@ -1190,10 +2878,10 @@ gst_gles_xoverlay_set_window_handle (GstXOverlay *overlay, guintptr handle)
     /* if we have not created a window yet, we'll use the application
       provided one. runtime switching is not yet supported */
     GST_DEBUG_OBJECT (sink, "Setting window handle");
-    if (sink->x11.window == 0) {
+    if (sink->window.window == 0) {
         GST_DEBUG_OBJECT (sink, "register new window id: %d", handle);
-        sink->x11.window = handle;
-        sink->x11.external_window = TRUE;
+        sink->window.window = handle;
+        sink->window.external_window = TRUE;
     } else {
         GST_ERROR_OBJECT (sink, "Changing window handle is not yet supported.");
     }
@@ -1239,8 +2927,23 @@ plugin_init (GstPlugin * plugin)
   GST_DEBUG_CATEGORY_INIT (gst_gles_sink_debug, "glesplugin",
       0, "OpenGL ES 2.0 plugin");
 
-  return gst_element_register (plugin, "glessink", GST_RANK_NONE,
-      GST_TYPE_GLES_SINK);
+  gst_gles_trace_register ();
+
+  if (!gst_element_register (plugin, "glessink", GST_RANK_NONE,
+          GST_TYPE_GLES_SINK))
+    return FALSE;
+
+#if GST_CHECK_VERSION(1, 0, 0)
+  if (!gst_element_register (plugin, "glescompositor", GST_RANK_NONE,
+          GST_TYPE_GLES_COMPOSITOR))
+    return FALSE;
+
+  if (!gst_element_register (plugin, "glesconvert", GST_RANK_NONE,
+          GST_TYPE_GLES_CONVERT))
+    return FALSE;
+#endif
+
+  return TRUE;
 }
 
 /* PACKAGE: this is usually set by autotools depending on some _INIT macro
@@ -31,8 +31,18 @@
 
 #include <gst/gst.h>
 #include <gst/video/gstvideosink.h>
+#include <gst/video/video.h>
 
 #include "shader.h"
+#include "timer.h"
+#include "stats.h"
+#include "trace.h"
+#include "pool.h"
+#include "window.h"
+#include "grid.h"
+#include "tonemap.h"
+#include "scale.h"
+#include "state.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
 #define GST_CAT_DEFAULT gst_gles_sink_debug
@@ -54,47 +64,142 @@ G_BEGIN_DECLS
 typedef struct _GstGLESSink        GstGLESSink;
 typedef struct _GstGLESSinkClass   GstGLESSinkClass;
 
-typedef struct _GstGLESWindow      GstGLESWindow;
 typedef struct _GstGLESContext     GstGLESContext;
+typedef struct _GstGLESGeometry    GstGLESGeometry;
 typedef struct _GstGLESThread      GstGLESThread;
 
-struct _GstGLESWindow
+typedef enum
 {
-    /* thread context */
-    GThread *thread;
-    volatile gboolean running;
-
-    gint width;
-    gint height;
-
-    /* x11 context */
-    Display *display;
-    Window window;
-    gboolean external_window;
+  GST_GLES_QUALITY_FULL = 0,
+  GST_GLES_QUALITY_BILINEAR,
+  GST_GLES_QUALITY_NO_DEINTERLACE,
+  GST_GLES_QUALITY_HALF_FBO,
+  GST_GLES_QUALITY_LOWEST = GST_GLES_QUALITY_HALF_FBO
+} GstGLESQuality;
+
+typedef enum
+{
+  GST_GLES_STARTUP_X11_OPEN = 0,
+  GST_GLES_STARTUP_X11_WINDOW,
+  GST_GLES_STARTUP_EGL_INITIALIZE,
+  GST_GLES_STARTUP_EGL_CONFIG,
+  GST_GLES_STARTUP_EGL_SURFACE,
+  GST_GLES_STARTUP_EGL_CONTEXT,
+  GST_GLES_STARTUP_SHADER_READ,
+  GST_GLES_STARTUP_SHADER_COMPILE,
+  GST_GLES_STARTUP_FRAMEBUFFER,
+  GST_GLES_STARTUP_FIRST_FRAME,
+  GST_GLES_STARTUP_PHASES
+} GstGLESStartupPhase;
+
+typedef EGLBoolean (EGLAPIENTRY *GstGLESSwapWithDamage) (EGLDisplay display,
+        EGLSurface surface, EGLint *rects, EGLint n_rects);
+typedef EGLBoolean (EGLAPIENTRY *GstGLESSetDamageRegion) (EGLDisplay display,
+        EGLSurface surface, EGLint *rects, EGLint n_rects);
+
+/* what the onscreen quad and the video rectangle are computed from */
+struct _GstGLESGeometry
+{
+    guint crop_top;
+    guint crop_bottom;
+    guint crop_left;
+    guint crop_right;
+    gint video_width;
+    gint video_height;
+    gint window_width;
+    gint window_height;
+    gint fbo_width;
+    gint fbo_height;
+    gfloat fbo_scale;
 };
 
 struct _GstGLESContext
 {
     gboolean initialized;
 
+    /* display and share group, referenced while the thread runs */
+    GstGLESPool *pool;
+    gboolean shared;
+
     /* egl context */
     EGLDisplay display;
     EGLSurface surface;
     EGLContext context;
+    EGLConfig config;
+
+    /* swap behaviour actually applied to the surface */
+    gint requested_interval;
+    gint swap_interval;
+    gboolean buffer_age;
+    gboolean preserved;
+
+    /* partial update support, NULL if not available */
+    GstGLESSwapWithDamage swap_with_damage;
+    GstGLESSetDamageRegion set_damage_region;
+
+    /* geometry the back buffers were drawn with and the number of
+     * swaps done since it last changed */
+    GstVideoRectangle video_rect;
+    gint surface_width;
+    gint surface_height;
+    guint frames_drawn;
+
+    /* monotonic time the last swap was issued and returned */
+    GstClockTime swap_start;
+    GstClockTime swap_end;
 
     /* shader programs */
     GstGLESShader deinterlace;
+    GstGLESShader convert;
     GstGLESShader scale;
-
-    /* textures for yuv input planes */
-    GstGLESTexture y_tex;
-    GstGLESTexture u_tex;
-    GstGLESTexture v_tex;
+    GLint line_height_loc;
+
+    /* bindings made on the context */
+    GstGLESState state;
+
+    /* the onscreen quad with the cropped texture coordinates, a copy of
+     * it, the window rectangle it is drawn to and the size of the source
+     * part in texels, updated when the geometry changes */
+    GstGLESGeometry geometry;
+    GLuint onscreen_vbo;
+    GLfloat onscreen_vertices[16];
+    GstVideoRectangle onscreen_rect;
+    gdouble source_width;
+    gdouble source_height;
+
+    /* textures for yuv input planes, split into cells where the frame
+     * is larger than the GL supports */
+    GstGLESGrid grid;
+    gint max_texture_size;
+    /* defines the yuv programs were built with for the grid layout and
+     * the colorimetry, and the tone mapping table of the latter */
+    gchar *yuv_defines;
+    GstGLESColor color;
+    GLuint lut_tex;
 
     GstGLESTexture rgb_tex;
+    /* the rgb texture is mipmapped for large downscales, if the GL
+     * can do so for any size */
+    gboolean npot_mipmaps;
+    gboolean mipmapped;
+
+    /* two pass scaling for the kernels other than bilinear */
+    GstGLESScaler scaler;
 
-    /* framebuffer object */
+    /* framebuffer object and the quad it is drawn with */
     GLuint framebuffer;
+    GLuint quad_vbo;
+    GLuint quad_ibo;
+
+    /* size the plane and fbo textures are allocated for and the size
+     * of the fbo texture, which is scaled down to fit the GL limit */
+    gint frame_width;
+    gint frame_height;
+    gint fbo_width;
+    gint fbo_height;
+
+    /* per stage render timings */
+    GstGLESTimer timer;
 };
 
 struct _GstGLESThread
@@ -107,26 +212,76 @@ struct _GstGLESThread
     GMutex data_lock;
     volatile gboolean render_done;
     volatile gboolean running;
+    /* set once the context setup finished, whether it succeeded or not */
+    gboolean init_done;
+    gboolean stopping;
+
+    /* a stopped sink keeps its context until the deadline, in
+     * monotonic time */
+    gboolean parked;
+    gint64 park_deadline;
 
     GstGLESContext gles;
 
     /* render data */
     GstBuffer *buf;
+    GstClockTime running_time;
+    GstClockTime target;
+
+    /* set atomically once gl_update_qos sent the QoS event of a frame */
+    gint qos_sent;
+
+    /* frame pacing, absolute times are in clock time */
+    GstClockID clock_id;
+    gboolean flushing;
+    GstClockTime last_vblank;
+    GstClockTime vblank_period;
+    GstClockTime render_cost;
+
+    /* average time from upload to present and of the swap alone */
+    GstClockTime present_latency;
+    GstClockTime present_cost;
+
+    /* adaptive quality governor */
+    GstGLESQuality quality;
+    guint overload_frames;
+    guint headroom_frames;
+    guint upgrade_frames;
+    guint frames_since_upgrade;
+
+    /* monotonic time the last statistics message was posted */
+    GstClockTime last_stats;
+
+    /* time to first frame, split by the phase of the startup path */
+    GstClockTime startup_begin;
+    GstClockTime startup[GST_GLES_STARTUP_PHASES];
+    GstClockTime startup_total;
+    gboolean startup_done;
 };
 
 struct _GstGLESSink
 {
   GstVideoSink basesink;
 
-  GstGLESWindow x11;
+  GstGLESWindow window;
   GstGLESThread gl_thread;
 
+  /* pool found or created on start */
+  GstGLESPool *pool;
+
   gint par_n;
   gint par_d;
 
   gint video_width;
   gint video_height;
 
+  /* layout of the planes and colorimetry, from the caps */
+  GstGLESGridFormat grid_format;
+  GstGLESColor color;
+#if GST_CHECK_VERSION(1, 0, 0)
+  GstVideoInfo info;
+#endif
+
   /* properties */
   guint crop_top;
   guint crop_bottom;
@@ -135,8 +290,38 @@ struct _GstGLESSink
 
   gboolean silent;
 
+  gint swap_interval;
+  gboolean low_latency;
+  gboolean pacing;
+  gboolean adaptive_quality;
+  gboolean report_timings;
+  guint stats_interval;
+  guint context_timeout;
+  GstGLESBackendType backend;
+  gboolean deinterlace;
+  gint window_width;
+  gint window_height;
+  gboolean readback;
+  gint max_texture_size;
+  GstGLESScaling scaling;
+  gboolean packed_upload;
+
   guint drop_first;
   guint dropped;
+
+  GstGLESStats stats;
+
+  gchar *trace_file;
+  GstGLESTrace trace;
+
+  /* frame budget from the caps and the max-lateness we set from it */
+  GstClockTime frame_duration;
+  gint64 max_lateness;
+
+  /* the render-delay we set, the measured delay on top of the one the
+   * application set */
+  GstClockTime render_delay;
+  GstClockTime user_render_delay;
 };
 
 struct _GstGLESSinkClass
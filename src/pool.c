@@ -0,0 +1,401 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <errno.h>
+#include <unistd.h>
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <gst/gst.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "pool.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+G_DEFINE_BOXED_TYPE (GstGLESPool, gst_gles_pool,
+                     gst_gles_pool_ref, gst_gles_pool_unref);
+
+/* protects the default pool and the refcounts, so the last unref can't
+ * race with a new user picking up the default */
+G_LOCK_DEFINE_STATIC (pools);
+static GstGLESPool *default_pools[GST_GLES_BACKEND_COUNT] = { NULL, };
+static guint live_pools = 0;
+
+/* position and texcoord of each corner, the texture is upside down */
+static const GLfloat quad_vertices[] =
+{
+    -1.0f, -1.0f,
+    0.0f, 1.0f,
+
+    1.0f, -1.0f,
+    1.0f, 1.0f,
+
+    1.0f, 1.0f,
+    1.0f, 0.0f,
+
+    -1.0f, 1.0f,
+    0.0f, 0.0f,
+};
+static const GLushort quad_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+/*
+ * ugly quirk, to workaround nvidia bugs
+ * closes left open file handles
+ */
+
+static void
+egl_close_file (const gchar *filename)
+{
+    const gchar *target_file;
+    GError *err = NULL;
+    GFileInfo *info;
+    GFile *file;
+
+    GST_DEBUG ("Check file handle: %s", filename);
+
+    file = g_file_new_for_path (filename);
+    info = g_file_query_info (file, "*",
+                              G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                              NULL, &err);
+    if (!info || err) {
+        GST_ERROR ("Could get file info: %s", err->message);
+        g_error_free(err);
+        goto cleanup;
+    }
+
+    GST_DEBUG ("File type is: %d", g_file_info_get_file_type(info));
+
+    if (!g_file_info_get_is_symlink (info)) {
+        GST_DEBUG ("File is no symlink");
+        goto cleanup;
+    }
+
+    target_file = g_file_info_get_symlink_target (info);
+    GST_DEBUG ("Check file resolves to: '%s'", target_file);
+
+    if (g_str_equal (target_file, "/dev/tegra_sema") ||
+        g_str_equal (target_file, "/dev/nvhost-gr2d") ||
+        g_str_equal (target_file, "/dev/nvhost-gr3d"))
+    {
+        gchar *basename = g_file_get_basename (file);
+        gint64 fid = g_ascii_strtoll (basename, NULL, 10);
+
+        if (fid > 0) {
+            GST_DEBUG ("Close file handle %" G_GINT64_FORMAT, fid);
+            if (close (fid) < 0) {
+                GST_ERROR ("Could not close file handle: %d", errno);
+            }
+        }
+
+        g_free (basename);
+    }
+
+cleanup:
+    g_object_unref (info);
+    g_object_unref (file);
+}
+
+static void
+egl_close_handles (void)
+{
+    GError *err = NULL;
+    GDir *directory;
+    const gchar *file;
+    gchar *path;
+
+
+    path = g_strdup_printf ("/proc/%u/fd", getpid());
+    GST_DEBUG ("Check for dead file handles in %s", path);
+
+    directory = g_dir_open (path, 0, &err);
+    if (!directory || err) {
+        GST_ERROR ("Could not list files: %s", err->message);
+        g_object_unref (err);
+        goto cleanup;
+    }
+
+    while ((file = g_dir_read_name(directory))) {
+        gchar *filename = g_strconcat(path, "/", file, NULL);
+        egl_close_file (filename);
+        g_free (filename);
+    }
+
+cleanup:
+    g_free (path);
+    g_dir_close (directory);
+}
+
+/* close_handles is set when this was the last pool in the process */
+static void
+gst_gles_pool_free (GstGLESPool *pool, gboolean close_handles)
+{
+    guint i;
+
+    GST_DEBUG ("Close GLES pool %p", pool);
+
+    for (i = 0; i < SHADER_COUNT; i++)
+        if (pool->binaries[i])
+            g_bytes_unref (pool->binaries[i]);
+
+    /* the quad goes away with the last context of the share group */
+    if (pool->context)
+        eglDestroyContext (pool->display, pool->context);
+
+    if (pool->display) {
+        eglTerminate (pool->display);
+        /* only safe once nobody in the process uses EGL anymore */
+        if (close_handles)
+            egl_close_handles ();
+    }
+
+    if (pool->native_display)
+        pool->backend->close_display (pool->native_display);
+
+    g_mutex_clear (&pool->lock);
+    g_slice_free (GstGLESPool, pool);
+}
+
+static GstGLESPool *
+gst_gles_pool_new (GstGLESBackendType backend)
+{
+    EGLint config_attribs[] =
+    {
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_DEPTH_SIZE, 16,
+        EGL_NONE
+    };
+    const EGLint context_attribs[] =
+    {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+    GstGLESPool *pool = g_slice_new0 (GstGLESPool);
+    GstClockTime start = gst_util_get_timestamp ();
+    EGLint num_configs;
+
+    pool->refcount = 1;
+    g_mutex_init (&pool->lock);
+    pool->backend = gst_gles_backend_get (backend);
+    config_attribs[1] = pool->backend->surface_type;
+
+    pool->display = pool->backend->open_display (&pool->native_display);
+    if (pool->display == EGL_NO_DISPLAY) {
+        GST_ERROR ("Could not get EGL display for the %s backend",
+                   pool->backend->name);
+        pool->display = NULL;
+        goto fail;
+    }
+    pool->open_time = gst_util_get_timestamp () - start;
+
+    start = gst_util_get_timestamp ();
+
+    if (!eglInitialize (pool->display, NULL, NULL)) {
+        GST_ERROR ("Could not initialize EGL display");
+        pool->display = NULL;
+        goto fail;
+    }
+    pool->initialize_time = gst_util_get_timestamp () - start;
+
+    if (!eglChooseConfig (pool->display, config_attribs, &pool->config, 1,
+                          &num_configs) || num_configs < 1) {
+        GST_ERROR ("Could not choose EGL config");
+        goto fail;
+    }
+
+    pool->context = eglCreateContext (pool->display, pool->config,
+                                      EGL_NO_CONTEXT, context_attribs);
+    if (pool->context == EGL_NO_CONTEXT) {
+        GST_WARNING ("Could not create share context, contexts are not "
+                     "shared");
+        pool->context = NULL;
+    }
+
+    GST_DEBUG ("Opened GLES pool %p for the %s backend", pool,
+               pool->backend->name);
+    live_pools++;
+
+    return pool;
+
+fail:
+    gst_gles_pool_free (pool, FALSE);
+    return NULL;
+}
+
+GstGLESPool *
+gst_gles_pool_get_default (GstGLESBackendType backend, gboolean *created)
+{
+    GstGLESPool *pool;
+
+    G_LOCK (pools);
+    *created = default_pools[backend] == NULL;
+    if (default_pools[backend])
+        default_pools[backend]->refcount++;
+    else
+        default_pools[backend] = gst_gles_pool_new (backend);
+    pool = default_pools[backend];
+    G_UNLOCK (pools);
+
+    return pool;
+}
+
+GstGLESPool *
+gst_gles_pool_ref (GstGLESPool *pool)
+{
+    G_LOCK (pools);
+    pool->refcount++;
+    G_UNLOCK (pools);
+
+    return pool;
+}
+
+void
+gst_gles_pool_unref (GstGLESPool *pool)
+{
+    gboolean last;
+    gboolean last_pool = FALSE;
+
+    G_LOCK (pools);
+    last = --pool->refcount == 0;
+    if (last) {
+        if (pool == default_pools[pool->backend->type])
+            default_pools[pool->backend->type] = NULL;
+        last_pool = --live_pools == 0;
+    }
+    G_UNLOCK (pools);
+
+    if (last)
+        gst_gles_pool_free (pool, last_pool);
+}
+
+void
+gl_create_quad (GLuint *vbo, GLuint *ibo)
+{
+    glGenBuffers (1, vbo);
+    glBindBuffer (GL_ARRAY_BUFFER, *vbo);
+    glBufferData (GL_ARRAY_BUFFER, sizeof (quad_vertices), quad_vertices,
+                  GL_STATIC_DRAW);
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers (1, ibo);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, *ibo);
+    glBufferData (GL_ELEMENT_ARRAY_BUFFER, sizeof (quad_indices),
+                  quad_indices, GL_STATIC_DRAW);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void
+gl_draw_quad (GstGLESShader *shader, GLuint vbo, GLuint ibo)
+{
+    glBindBuffer (GL_ARRAY_BUFFER, vbo);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    glVertexAttribPointer (shader->position_loc, 2,
+                           GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat),
+                           (const GLvoid *) 0);
+
+    glVertexAttribPointer (shader->texcoord_loc, 2,
+                           GL_FLOAT, GL_FALSE, 4 * sizeof (GLfloat),
+                           (const GLvoid *) (2 * sizeof (GLfloat)));
+
+    glEnableVertexAttribArray (shader->position_loc);
+    glEnableVertexAttribArray (shader->texcoord_loc);
+
+    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const GLvoid *) 0);
+
+    /* onscreen passes draw from client memory */
+    glBindBuffer (GL_ARRAY_BUFFER, 0);
+    glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void
+gst_gles_pool_get_quad (GstGLESPool *pool, GLuint *vbo, GLuint *ibo)
+{
+    g_mutex_lock (&pool->lock);
+    if (!pool->quad_vbo) {
+        gl_create_quad (&pool->quad_vbo, &pool->quad_ibo);
+        /* other contexts must not use the buffers before they exist */
+        glFinish ();
+    }
+    *vbo = pool->quad_vbo;
+    *ibo = pool->quad_ibo;
+    g_mutex_unlock (&pool->lock);
+}
+
+GBytes *
+gst_gles_pool_get_binary (GstGLESPool *pool, GstGLESShaderTypes type,
+                          GLenum *format)
+{
+    GBytes *binary = NULL;
+
+    g_mutex_lock (&pool->lock);
+    if (pool->binaries[type]) {
+        binary = g_bytes_ref (pool->binaries[type]);
+        *format = pool->binary_formats[type];
+    }
+    g_mutex_unlock (&pool->lock);
+
+    return binary;
+}
+
+void
+gst_gles_pool_set_binary (GstGLESPool *pool, GstGLESShaderTypes type,
+                          GLenum format, GBytes *binary)
+{
+    g_mutex_lock (&pool->lock);
+    if (!pool->binaries[type]) {
+        pool->binaries[type] = g_bytes_ref (binary);
+        pool->binary_formats[type] = format;
+    }
+    g_mutex_unlock (&pool->lock);
+}
+
+#if GST_CHECK_VERSION(1, 2, 0)
+GstContext *
+gst_gles_pool_context_new (GstGLESPool *pool)
+{
+    GstContext *context = gst_context_new (GST_GLES_POOL_CONTEXT_TYPE, TRUE);
+
+    gst_structure_set (gst_context_writable_structure (context),
+                       "pool", GST_TYPE_GLES_POOL, pool, NULL);
+
+    return context;
+}
+
+GstGLESPool *
+gst_gles_pool_from_context (GstContext *context)
+{
+    GstGLESPool *pool = NULL;
+
+    if (!g_str_equal (gst_context_get_context_type (context),
+                      GST_GLES_POOL_CONTEXT_TYPE))
+        return NULL;
+
+    if (!gst_structure_get (gst_context_get_structure (context),
+                            "pool", GST_TYPE_GLES_POOL, &pool, NULL))
+        return NULL;
+
+    return pool;
+}
+#endif
@@ -0,0 +1,96 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _POOL_H__
+#define _POOL_H__
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <gst/gst.h>
+
+#include "shader.h"
+#include "window.h"
+
+/* GstContext type the pool is shared with */
+#define GST_GLES_POOL_CONTEXT_TYPE "gst.gles.pool"
+
+#define GST_TYPE_GLES_POOL (gst_gles_pool_get_type ())
+
+typedef struct _GstGLESPool        GstGLESPool;
+
+/* display connection, EGL display and share group used by every
+ * instance in a process. Each instance still has its own window,
+ * surface and context, created in the share group of the pool */
+struct _GstGLESPool
+{
+    volatile gint refcount;
+    GMutex lock;
+
+    /* window system the display was opened for */
+    const GstGLESBackend *backend;
+    gpointer native_display;
+    EGLDisplay display;
+
+    /* keeps the share group alive, never made current */
+    EGLConfig config;
+    EGLContext context;
+
+    /* static fullscreen quad, created by the first user */
+    GLuint quad_vbo;
+    GLuint quad_ibo;
+
+    /* program binaries by shader type, format 0 if there is none */
+    GBytes *binaries[SHADER_COUNT];
+    GLenum binary_formats[SHADER_COUNT];
+
+    /* how long the creation took */
+    GstClockTime open_time;
+    GstClockTime initialize_time;
+};
+
+GType gst_gles_pool_get_type (void);
+
+/* the process-wide pool of a backend, created on first use. *created
+ * tells whether this call created it */
+GstGLESPool *gst_gles_pool_get_default (GstGLESBackendType backend,
+                                        gboolean *created);
+GstGLESPool *gst_gles_pool_ref (GstGLESPool *pool);
+void gst_gles_pool_unref (GstGLESPool *pool);
+
+/* the shared quad, created in the current context if needed */
+void gst_gles_pool_get_quad (GstGLESPool *pool, GLuint *vbo, GLuint *ibo);
+/* creates the buffers of a fullscreen quad in the current context */
+void gl_create_quad (GLuint *vbo, GLuint *ibo);
+/* draws the quad with the current program into the bound framebuffer */
+void gl_draw_quad (GstGLESShader *shader, GLuint vbo, GLuint ibo);
+
+GBytes *gst_gles_pool_get_binary (GstGLESPool *pool,
+                                  GstGLESShaderTypes type, GLenum *format);
+void gst_gles_pool_set_binary (GstGLESPool *pool, GstGLESShaderTypes type,
+                               GLenum format, GBytes *binary);
+
+#if GST_CHECK_VERSION(1, 2, 0)
+GstContext *gst_gles_pool_context_new (GstGLESPool *pool);
+/* the pool held by a context, with a new reference, or NULL */
+GstGLESPool *gst_gles_pool_from_context (GstContext *context);
+#endif
+
+#endif
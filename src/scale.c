@@ -0,0 +1,305 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <GLES2/gl2.h>
+
+#include "scale.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+/* the most taps of any filter, lanczos with three lobes a side */
+#define SCALE_MAX_TAPS 6
+
+/* the weights texture is on the unit after the tone mapping table */
+#define SCALE_WEIGHTS_UNIT 5
+
+/* the rgb texture and the intermediate texture */
+#define SCALE_SOURCE_UNIT 3
+
+/* the whole intermediate texture, its first row at the bottom like the
+ * rows the horizontal pass rendered */
+static const GLfloat intermediate_quad[] = {
+    -1.0f, -1.0f, 0.0f, 0.0f,
+    1.0f, -1.0f, 1.0f, 0.0f,
+    1.0f, 1.0f, 1.0f, 1.0f,
+    -1.0f, 1.0f, 0.0f, 1.0f
+};
+
+GType
+gst_gles_scaling_get_type (void)
+{
+    static volatile gsize scaling_type = 0;
+    static const GEnumValue scalings[] = {
+        { GST_GLES_SCALING_BILINEAR, "Bilinear, fastest", "bilinear" },
+        { GST_GLES_SCALING_BICUBIC, "Bicubic (Catmull-Rom), 4 taps",
+          "bicubic" },
+        { GST_GLES_SCALING_LANCZOS, "Lanczos with 3 lobes, 6 taps",
+          "lanczos" },
+        { 0, NULL, NULL }
+    };
+
+    if (g_once_init_enter (&scaling_type)) {
+        GType tmp = g_enum_register_static ("GstGLESScaling", scalings);
+        g_once_init_leave (&scaling_type, tmp);
+    }
+
+    return (GType) scaling_type;
+}
+
+guint
+gst_gles_scaling_taps (GstGLESScaling scaling)
+{
+    switch (scaling) {
+        case GST_GLES_SCALING_BICUBIC:
+            return 4;
+        case GST_GLES_SCALING_LANCZOS:
+            return 6;
+        default:
+            return 2;
+    }
+}
+
+/* Catmull-Rom, the cubic with B = 0 and C = 0.5 */
+static gdouble
+cubic (gdouble x)
+{
+    x = fabs (x);
+
+    if (x < 1.0)
+        return 1.5 * x * x * x - 2.5 * x * x + 1.0;
+    if (x < 2.0)
+        return -0.5 * x * x * x + 2.5 * x * x - 4.0 * x + 2.0;
+    return 0.0;
+}
+
+static gdouble
+sinc (gdouble x)
+{
+    if (fabs (x) < 1e-8)
+        return 1.0;
+    return sin (G_PI * x) / (G_PI * x);
+}
+
+static gdouble
+lanczos (gdouble x)
+{
+    if (fabs (x) >= 3.0)
+        return 0.0;
+    return sinc (x) * sinc (x / 3.0);
+}
+
+void
+gst_gles_scaling_build_weights (GstGLESScaling scaling, gfloat *weights)
+{
+    guint taps = gst_gles_scaling_taps (scaling);
+    guint phase;
+    guint i;
+
+    for (phase = 0; phase < SCALE_PHASES; phase++) {
+        /* the weights hold for the whole texel of the phase, so they are
+         * taken at its centre */
+        gdouble offset = (phase + 0.5) / SCALE_PHASES;
+        gdouble w[SCALE_MAX_TAPS];
+        gdouble sum = 0.0;
+
+        for (i = 0; i < taps; i++) {
+            /* the shader reads the taps from base - taps / 2 + 1 on */
+            gdouble x = (gint) i - (gint) taps / 2 + 1 - offset;
+
+            if (scaling == GST_GLES_SCALING_LANCZOS)
+                w[i] = lanczos (x);
+            else if (scaling == GST_GLES_SCALING_BICUBIC)
+                w[i] = cubic (x);
+            else
+                w[i] = MAX (1.0 - fabs (x), 0.0);
+            sum += w[i];
+        }
+
+        for (i = 0; i < taps; i++)
+            weights[i * SCALE_PHASES + phase] = w[i] / sum;
+    }
+}
+
+static void
+gl_scaler_upload_weights (GstGLESScaler *scaler)
+{
+    guint taps = gst_gles_scaling_taps (scaler->scaling);
+    gfloat weights[SCALE_MAX_TAPS * SCALE_PHASES];
+    guint16 packed[SCALE_MAX_TAPS * SCALE_PHASES];
+    guint i;
+
+    gst_gles_scaling_build_weights (scaler->scaling, weights);
+
+    /* lanczos has negative lobes, so the weights are stored as
+     * (w + 1) / 2 */
+    for (i = 0; i < taps * SCALE_PHASES; i++)
+        packed[i] = CLAMP ((weights[i] + 1.0) / 2.0, 0.0, 1.0) * 65535.0 + 0.5;
+
+    glActiveTexture (GL_TEXTURE0 + SCALE_WEIGHTS_UNIT);
+    if (!scaler->weights) {
+        glGenTextures (1, &scaler->weights);
+        glBindTexture (GL_TEXTURE_2D, scaler->weights);
+
+        /* byte pairs can't be interpolated */
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture (GL_TEXTURE_2D, scaler->weights);
+    }
+
+    /* little endian, so the low byte lands in luminance */
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, SCALE_PHASES, taps,
+                  0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, packed);
+}
+
+gint
+gl_scaler_init (GstElement *sink, GstGLESScaler *scaler,
+                GstGLESScaling scaling)
+{
+    gchar *defines;
+    gint ret;
+
+    gl_delete_shader (&scaler->program);
+    scaler->scaling = scaling;
+
+    defines = g_strdup_printf ("#define TAPS %u\n",
+                               gst_gles_scaling_taps (scaling));
+    ret = gl_begin_shader_variant (sink, &scaler->program,
+                                   SHADER_SCALE_KERNEL, defines);
+    g_free (defines);
+    if (ret == 0)
+        ret = gl_finish_shader (sink, &scaler->program);
+    if (ret < 0) {
+        GST_ERROR_OBJECT (sink, "Could not build scaling program: %d", ret);
+        return ret;
+    }
+
+    glUseProgram (scaler->program.program);
+    glUniform1i (glGetUniformLocation (scaler->program.program, "s_tex"),
+                 SCALE_SOURCE_UNIT);
+    glUniform1i (glGetUniformLocation (scaler->program.program, "s_weights"),
+                 SCALE_WEIGHTS_UNIT);
+    scaler->axis_loc = glGetUniformLocation (scaler->program.program, "axis");
+    scaler->source_size_loc = glGetUniformLocation (scaler->program.program,
+                                                    "source_size");
+    scaler->limits_loc = glGetUniformLocation (scaler->program.program,
+                                               "limits");
+
+    gl_scaler_upload_weights (scaler);
+
+    if (!scaler->framebuffer)
+        glGenFramebuffers (1, &scaler->framebuffer);
+
+    if (!scaler->quad_vbo) {
+        glGenBuffers (1, &scaler->quad_vbo);
+        glBindBuffer (GL_ARRAY_BUFFER, scaler->quad_vbo);
+        glBufferData (GL_ARRAY_BUFFER, sizeof (intermediate_quad),
+                      intermediate_quad, GL_STATIC_DRAW);
+    }
+
+    GST_DEBUG_OBJECT (sink, "Scaling with %u taps",
+                      gst_gles_scaling_taps (scaling));
+    return 0;
+}
+
+void
+gl_scaler_free (GstGLESScaler *scaler)
+{
+    gl_delete_shader (&scaler->program);
+
+    if (scaler->weights)
+        glDeleteTextures (1, &scaler->weights);
+    if (scaler->intermediate.id)
+        glDeleteTextures (1, &scaler->intermediate.id);
+    if (scaler->framebuffer)
+        glDeleteFramebuffers (1, &scaler->framebuffer);
+    if (scaler->quad_vbo)
+        glDeleteBuffers (1, &scaler->quad_vbo);
+
+    memset (scaler, 0, sizeof (GstGLESScaler));
+}
+
+void
+gl_scaler_horizontal (GstGLESScaler *scaler, GstGLESState *state,
+                      const GLfloat *vertices, GLuint vbo, GLuint ibo,
+                      gint width, gint height, gint source_width)
+{
+    gfloat left = MIN (vertices[2], vertices[6]) * source_width;
+    gfloat right = MAX (vertices[2], vertices[6]) * source_width;
+
+    /* unit 3 holds the source, so the weights unit is used to set the
+     * intermediate texture up */
+    if (!scaler->intermediate.id) {
+        glGenTextures (1, &scaler->intermediate.id);
+        gl_state_bind_texture (state, SCALE_WEIGHTS_UNIT,
+                               scaler->intermediate.id);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        scaler->width = 0;
+    }
+
+    gl_state_bind_framebuffer (state, scaler->framebuffer);
+    if (scaler->width != width || scaler->height != height) {
+        gl_state_bind_texture (state, SCALE_WEIGHTS_UNIT,
+                               scaler->intermediate.id);
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
+                      GL_UNSIGNED_BYTE, NULL);
+        glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                GL_TEXTURE_2D, scaler->intermediate.id, 0);
+        scaler->width = width;
+        scaler->height = height;
+    }
+    gl_state_bind_texture (state, SCALE_WEIGHTS_UNIT, scaler->weights);
+
+    gl_state_viewport (state, 0, 0, width, height);
+    gl_state_use_program (state, scaler->program.program);
+    glUniform2f (scaler->axis_loc, 1.0f, 0.0f);
+    glUniform1f (scaler->source_size_loc, source_width);
+    glUniform2f (scaler->limits_loc, floorf (left) + 0.5f,
+                 MAX (ceilf (right) - 0.5f, floorf (left) + 0.5f));
+
+    gl_state_quad_attributes (state, vbo, ibo, 0);
+    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const GLvoid *) 0);
+}
+
+void
+gl_scaler_vertical (GstGLESScaler *scaler, GstGLESState *state, GLuint ibo)
+{
+    gl_state_bind_texture (state, SCALE_SOURCE_UNIT, scaler->intermediate.id);
+
+    gl_state_use_program (state, scaler->program.program);
+    glUniform2f (scaler->axis_loc, 0.0f, 1.0f);
+    glUniform1f (scaler->source_size_loc, scaler->height);
+    glUniform2f (scaler->limits_loc, 0.5f, scaler->height - 0.5f);
+
+    gl_state_quad_attributes (state, scaler->quad_vbo, ibo, 0);
+    glDrawElements (GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (const GLvoid *) 0);
+}
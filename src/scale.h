@@ -0,0 +1,103 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _SCALE_H__
+#define _SCALE_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+
+#include "shader.h"
+#include "state.h"
+
+/* filters the onscreen pass can scale the video with */
+typedef enum
+{
+    GST_GLES_SCALING_BILINEAR = 0,
+    GST_GLES_SCALING_BICUBIC,
+    GST_GLES_SCALING_LANCZOS
+} GstGLESScaling;
+
+#define GST_TYPE_GLES_SCALING (gst_gles_scaling_get_type ())
+
+/* phases of a texel the kernel weights are tabulated for */
+#define SCALE_PHASES 64
+
+/* below this factor the source is mipmapped first, so no filter has to
+ * cover more than two source texels per output pixel */
+#define SCALE_MIPMAP_FACTOR 0.5
+
+typedef struct _GstGLESScaler      GstGLESScaler;
+
+/* separable two pass scaling: a horizontal pass into an intermediate
+ * texture of the output width and the source height, and a vertical
+ * pass from there into the window */
+struct _GstGLESScaler
+{
+    GstGLESScaling scaling;
+    GstGLESShader program;
+    GLint axis_loc;
+    GLint source_size_loc;
+    GLint limits_loc;
+
+    /* weights of the taps by phase, in a row per tap */
+    GLuint weights;
+
+    GLuint framebuffer;
+    GstGLESTexture intermediate;
+    gint width;
+    gint height;
+    /* the quad the vertical pass draws the intermediate texture with */
+    GLuint quad_vbo;
+};
+
+GType gst_gles_scaling_get_type (void);
+
+/* taps a filter needs in each direction, 2 for bilinear which the
+ * texture unit does on its own */
+guint gst_gles_scaling_taps (GstGLESScaling scaling);
+
+/* fills one row of SCALE_PHASES weights per tap, normalized so the taps
+ * of a phase sum up to one */
+void gst_gles_scaling_build_weights (GstGLESScaling scaling,
+                                     gfloat *weights);
+
+/* builds the program and the weights for a filter other than bilinear,
+ * returns 0 on success. Binds without the state cache, which has to be
+ * invalidated afterwards */
+gint gl_scaler_init (GstElement *sink, GstGLESScaler *scaler,
+                     GstGLESScaling scaling);
+void gl_scaler_free (GstGLESScaler *scaler);
+
+/* runs the horizontal pass from the texture bound to unit 3 into the
+ * intermediate texture of width x height. vbo holds the quad of the
+ * source part like in the onscreen pass and vertices a copy of it,
+ * source_width is the width of the bound texture */
+void gl_scaler_horizontal (GstGLESScaler *scaler, GstGLESState *state,
+                           const GLfloat *vertices, GLuint vbo, GLuint ibo,
+                           gint width, gint height, gint source_width);
+
+/* runs the vertical pass from the intermediate texture into the bound
+ * framebuffer, whose viewport is already set */
+void gl_scaler_vertical (GstGLESScaler *scaler, GstGLESState *state,
+                         GLuint ibo);
+
+#endif
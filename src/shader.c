@@ -19,7 +19,6 @@
  * Boston, MA 02111-1307, USA.
  */
 
-#include <string.h>
 #include <stdlib.h>
 #include <glib.h>
 #include <gio/gio.h>
@@ -27,6 +26,7 @@
 #define GST_USE_UNSTABLE_API
 #include <gst/gst.h>
 #include <GLES2/gl2.h>
+#include <EGL/egl.h>
 
 #include "shader.h"
 #include "gstglessink.h"
@@ -34,12 +34,32 @@
 /* FIXME: Should be part of the GLES headers */
 #define GL_NVIDIA_PLATFORM_BINARY_NV                            0x890B
 
+#ifndef GL_PROGRAM_BINARY_LENGTH_OES
+#define GL_PROGRAM_BINARY_LENGTH_OES                            0x8741
+#endif
+
+typedef void (GL_APIENTRYP GstGLESMaxShaderCompilerThreads) (GLuint count);
+typedef void (GL_APIENTRYP GstGLESGetProgramBinary) (GLuint program,
+        GLsizei size, GLsizei *length, GLenum *format, GLvoid *binary);
+typedef void (GL_APIENTRYP GstGLESProgramBinary) (GLuint program,
+        GLenum format, const GLvoid *binary, GLint length);
+
 GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
 
 
 static const gchar* shader_basenames[] = {
     "deint_linear", /* SHADER_DEINT_LINEAR */
-    "copy" /* SHADER_COPY, simple linear scaled copy shader */
+    "copy", /* SHADER_COPY, simple linear scaled copy shader */
+    "yuv_rgb", /* SHADER_YUV_RGB, conversion without deinterlacing */
+    "scale_kernel" /* SHADER_SCALE_KERNEL, one pass of separable scaling */
+};
+
+/* source put in front of the fragment shader, NULL for none */
+static const gchar* shader_preludes[] = {
+    "yuv_common", /* SHADER_DEINT_LINEAR */
+    NULL, /* SHADER_COPY */
+    "yuv_common", /* SHADER_YUV_RGB */
+    NULL /* SHADER_SCALE_KERNEL */
 };
 
 #ifndef DATA_DIR
@@ -51,6 +71,15 @@ static const gchar* shader_basenames[] = {
 
 #define VERTEX_SHADER_BASENAME "vertex"
 
+/* lets uninstalled builds, e.g. the test suite, load the shaders from
+ * the source tree */
+static const gchar *
+gl_shader_dir (void)
+{
+    const gchar *dir = g_getenv ("GST_GLES_SHADER_DIR");
+    return dir ? dir : DATA_DIR;
+}
+
 static gboolean gl_extension_available(const gchar *extension)
 {
     const gchar *gl_extensions = (gchar*)glGetString(GL_EXTENSIONS);
@@ -59,11 +88,13 @@ static gboolean gl_extension_available(const gchar *extension)
 
 static GLuint
 gl_load_binary_shader (GstElement *sink, const char *filename,
-                       GLenum type)
+                       GLenum type, GstClockTime *read_time)
 {
     GLbyte *binary = NULL;
     GFile *file = NULL;
     GLuint shader = 0;
+    GstClockTime start;
+    gboolean loaded;
     GLsizei length;
     GLint err;
 
@@ -81,8 +112,12 @@ gl_load_binary_shader (GstElement *sink, const char *filename,
         goto cleanup;
     }
 
-    if (!g_file_load_contents (file, NULL, (char**)&binary,
-                               (gsize*)&length, NULL, NULL)) {
+    start = gst_util_get_timestamp ();
+    loaded = g_file_load_contents (file, NULL, (char**)&binary,
+                                   (gsize*)&length, NULL, NULL);
+    *read_time += gst_util_get_timestamp () - start;
+
+    if (!loaded) {
         GST_ERROR_OBJECT(sink, "Could not read binary shader from %s",
                          filename);
         glDeleteShader (shader);
@@ -106,17 +141,46 @@ cleanup:
     return shader;
 }
 
-/* load and compile a shader src into a shader program */
+/* reads a shader source file, returns NULL on failure */
+static gchar *
+gl_read_source (GstElement *sink, const gchar *filename,
+                GstClockTime *read_time)
+{
+    GFile *file;
+    gchar *src = NULL;
+    GstClockTime start;
+    gboolean loaded;
+    GError *err = NULL;
+
+    file = g_file_new_for_path (filename);
+    start = gst_util_get_timestamp ();
+    loaded = g_file_load_contents (file, NULL, &src, NULL, NULL, &err);
+    *read_time += gst_util_get_timestamp () - start;
+    g_object_unref (file);
+
+    if (!loaded) {
+        GST_ERROR_OBJECT (sink, "Could not read shader source: %s\n",
+                         err->message);
+        g_error_free (err);
+        return NULL;
+    }
+
+    return src;
+}
+
+/* load and compile a shader src into a shader program, defines and the
+ * prelude are put in front of the source if not NULL */
 static GLuint
 gl_load_source_shader (GstElement *sink, const char *shader_filename,
-                       GLenum type)
+                       GLenum type, const gchar *defines,
+                       const gchar *prelude_filename,
+                       GstClockTime *read_time)
 {
-    GFile *shader_file;
+    const GLchar *sources[3];
+    GLsizei count = 0;
+    gchar *prelude_src = NULL;
+    gchar *shader_src;
     GLuint shader = 0;
-    char *shader_src;
-    GLint compiled;
-    gsize src_len;
-    GError *err;
 
     /* create a shader object */
     shader = glCreateShader (type);
@@ -126,79 +190,100 @@ gl_load_source_shader (GstElement *sink, const char *shader_filename,
     }
 
     /* read shader source from file */
-    shader_file = g_file_new_for_path (shader_filename);
-    if (!g_file_load_contents (shader_file, NULL, &shader_src, &src_len,
-                               NULL, &err)) {
-        GST_ERROR_OBJECT (sink, "Could not read shader source: %s\n",
-                         err->message);
-        g_free (err);
-        g_object_unref (shader_file);
+    if (prelude_filename) {
+        prelude_src = gl_read_source (sink, prelude_filename, read_time);
+        if (!prelude_src) {
+            glDeleteShader (shader);
+            return 0;
+        }
+    }
+
+    shader_src = gl_read_source (sink, shader_filename, read_time);
+    if (!shader_src) {
+        g_free (prelude_src);
         glDeleteShader (shader);
         return 0;
     }
 
-    /* load source into shader object */
-    src_len = strlen (shader_src);
-    glShaderSource (shader, 1, (const GLchar**) &shader_src,
-                    (const GLint*) &src_len);
+    /* load source into shader object, the strings are nul terminated */
+    if (defines)
+        sources[count++] = defines;
+    if (prelude_src)
+        sources[count++] = prelude_src;
+    sources[count++] = shader_src;
+    glShaderSource (shader, count, sources, NULL);
 
     /* shader code has been loaded into GL, free all resources
      * we have used to load the shader */
+    g_free (prelude_src);
     g_free (shader_src);
-    g_object_unref (shader_file);
 
-    /* compile the shader */
+    /* compile the shader, the status is only checked once the program
+     * is linked so the driver may compile in the background */
     glCompileShader (shader);
 
-    /* check compiler status */
-    glGetShaderiv (shader, GL_COMPILE_STATUS, &compiled);
-    if (!compiled) {
-        GLint info_len = 0;
+    return shader;
+}
 
-        glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &info_len);
-        if(info_len > 1) {
-            char *info_log = malloc (sizeof(char) * info_len);
-            glGetShaderInfoLog (shader, info_len, NULL, info_log);
+/* logs why a shader failed to compile, if it did */
+static void
+gl_check_compiled (GstElement *sink, GLuint shader)
+{
+    GLint compiled;
+    GLint info_len = 0;
 
-            GST_ERROR_OBJECT (sink, "Failed to compile shader: %s", info_log);
-            free (info_log);
-        }
+    glGetShaderiv (shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled)
+        return;
 
-        glDeleteShader (shader);
-        shader = 0;
-    } else {
-	GST_DEBUG_OBJECT (sink, "Shader compiled succesfully");
-    }
+    glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &info_len);
+    if(info_len > 1) {
+        char *info_log = malloc (sizeof(char) * info_len);
+        glGetShaderInfoLog (shader, info_len, NULL, info_log);
 
-    return shader;
+        GST_ERROR_OBJECT (sink, "Failed to compile shader: %s", info_log);
+        free (info_log);
+    }
 }
 
 /*
  * Loads a shader from either precompiled binary file when possible.
  * If no binary is found the source file is taken and compiled at
- * runtime. */
+ * runtime, behind the source of prelude if that is not NULL. The
+ * binaries are built without defines, from the prelude and the shader
+ * source, so variants always compile the source. */
 static GLuint
-gl_load_shader (GstElement *sink, const gchar *basename, const GLenum type)
+gl_load_shader (GstElement *sink, const gchar *basename, const GLenum type,
+                const gchar *defines, const gchar *prelude,
+                GstClockTime *read_time)
 {
-    GstGLESSink *el = GST_GLES_SINK (sink);
+    gchar *prelude_filename = NULL;
     gchar *filename;
     GLuint shader;
 
-    filename = g_strdup_printf ("%s/%s%s", DATA_DIR, basename,
+    filename = g_strdup_printf ("%s/%s%s", gl_shader_dir (), basename,
                                 SHADER_EXT_BINARY);
-    GST_DEBUG_OBJECT (el, "Load binary shader from %s", filename);
+    GST_DEBUG_OBJECT (sink, "Load binary shader from %s", filename);
 
-    shader = gl_load_binary_shader (sink, filename, type);
+    /* not every shader comes with a precompiled binary */
+    shader = 0;
+    if (!defines && g_file_test (filename, G_FILE_TEST_EXISTS))
+        shader = gl_load_binary_shader (sink, filename, type, read_time);
     if (!shader) {
         g_free (filename);
-        filename = g_strdup_printf ("%s/%s%s", DATA_DIR,
+        filename = g_strdup_printf ("%s/%s%s", gl_shader_dir (),
                                     basename,
                                     SHADER_EXT_SOURCE);
-        GST_DEBUG_OBJECT(el, "Load source shader from %s", filename);
+        if (prelude)
+            prelude_filename = g_strdup_printf ("%s/%s%s", gl_shader_dir (),
+                                                prelude, SHADER_EXT_SOURCE);
+        GST_DEBUG_OBJECT(sink, "Load source shader from %s", filename);
 
-        shader = gl_load_source_shader(sink, filename, type);
+        shader = gl_load_source_shader(sink, filename, type, defines,
+                                       prelude_filename, read_time);
     }
 
+    g_free (prelude_filename);
     g_free (filename);
     return shader;
 }
@@ -209,30 +294,62 @@ gl_load_shader (GstElement *sink, const gchar *basename, const GLenum type)
  * through process_type */
 static gint
 gl_load_shaders (GstElement *sink, GstGLESShader *shader,
-                 GstGLESShaderTypes process_type)
+                 GstGLESShaderTypes process_type, const gchar *defines)
 {
     shader->vertex_shader = gl_load_shader (sink, VERTEX_SHADER_BASENAME,
-                                          GL_VERTEX_SHADER);
+                                          GL_VERTEX_SHADER, NULL, NULL,
+                                          &shader->read_time);
     if (!shader->vertex_shader)
         return -EINVAL;
 
     shader->fragment_shader = gl_load_shader (sink,
                                             shader_basenames[process_type],
-                                            GL_FRAGMENT_SHADER);
+                                            GL_FRAGMENT_SHADER, defines,
+                                            shader_preludes[process_type],
+                                            &shader->read_time);
     if (!shader->fragment_shader)
         return -EINVAL;
 
     return 0;
 }
 
+gboolean
+gl_shader_parallel_compile (GstElement *sink)
+{
+    GstGLESMaxShaderCompilerThreads max_threads;
+
+    if (!gl_extension_available ("GL_KHR_parallel_shader_compile") &&
+        !gl_extension_available ("GL_ARB_parallel_shader_compile"))
+        return FALSE;
+
+    max_threads = (GstGLESMaxShaderCompilerThreads)
+            eglGetProcAddress ("glMaxShaderCompilerThreadsKHR");
+    if (!max_threads)
+        return FALSE;
+
+    /* let the implementation pick the number of threads */
+    max_threads (0xffffffff);
+    GST_DEBUG_OBJECT (sink, "Compiling shaders in parallel");
+
+    return TRUE;
+}
+
 gint
-gl_init_shader (GstElement *sink, GstGLESShader *shader,
-                GstGLESShaderTypes process_type)
+gl_begin_shader (GstElement *sink, GstGLESShader *shader,
+                 GstGLESShaderTypes process_type)
+{
+    return gl_begin_shader_variant (sink, shader, process_type, NULL);
+}
+
+gint
+gl_begin_shader_variant (GstElement *sink, GstGLESShader *shader,
+                         GstGLESShaderTypes process_type,
+                         const gchar *defines)
 {
-    gint linked;
     GLint err;
     gint ret;
 
+    shader->read_time = 0;
     shader->program = glCreateProgram();
     if(!shader->program) {
         GST_ERROR_OBJECT(sink, "Could not create GL program");
@@ -240,7 +357,7 @@ gl_init_shader (GstElement *sink, GstGLESShader *shader,
     }
 
     /* load the shaders */
-    ret = gl_load_shaders(sink, shader, process_type);
+    ret = gl_load_shaders(sink, shader, process_type, defines);
     if(ret < 0) {
         GST_ERROR_OBJECT(sink, "Could not create GL shaders: %d", ret);
         return ret;
@@ -258,15 +375,28 @@ gl_init_shader (GstElement *sink, GstGLESShader *shader,
         GST_ERROR_OBJECT (sink, "Error while attaching the fragment shader: 0x%04x\n", err);
     }
 
+    /* fixed locations, so every program reads the same attributes */
     glBindAttribLocation(shader->program, 0, "vPosition");
+    glBindAttribLocation(shader->program, 1, "aTexcoord");
     glLinkProgram(shader->program);
 
-    /* check linker status */
+    return 0;
+}
+
+gint
+gl_finish_shader (GstElement *sink, GstGLESShader *shader)
+{
+    gint linked;
+
+    /* check linker status, this waits for a background compile */
     glGetProgramiv(shader->program, GL_LINK_STATUS, &linked);
     if(!linked) {
         GLint info_len = 0;
         GST_ERROR_OBJECT(sink, "Linker failure");
 
+        gl_check_compiled (sink, shader->vertex_shader);
+        gl_check_compiled (sink, shader->fragment_shader);
+
         glGetProgramiv(shader->program, GL_INFO_LOG_LENGTH, &info_len);
         if(info_len > 1) {
             char *info_log = malloc(sizeof(char) * info_len);
@@ -277,6 +407,7 @@ gl_init_shader (GstElement *sink, GstGLESShader *shader,
         }
 
         glDeleteProgram(shader->program);
+        shader->program = 0;
         return -EINVAL;
     }
 
@@ -290,6 +421,87 @@ gl_init_shader (GstElement *sink, GstGLESShader *shader,
     return 0;
 }
 
+gint
+gl_begin_shader_binary (GstElement *sink, GstGLESShader *shader,
+                        GLenum format, GBytes *binary)
+{
+    GstGLESProgramBinary program_binary;
+    gint linked;
+
+    if (!gl_extension_available ("GL_OES_get_program_binary"))
+        return -ENOTSUP;
+
+    program_binary = (GstGLESProgramBinary)
+            eglGetProcAddress ("glProgramBinaryOES");
+    if (!program_binary)
+        return -ENOTSUP;
+
+    shader->read_time = 0;
+    shader->vertex_shader = 0;
+    shader->fragment_shader = 0;
+    shader->program = glCreateProgram();
+    if(!shader->program) {
+        GST_ERROR_OBJECT(sink, "Could not create GL program");
+        return -ENOMEM;
+    }
+
+    program_binary (shader->program, format, g_bytes_get_data (binary, NULL),
+                    g_bytes_get_size (binary));
+
+    /* a driver update may reject binaries it produced before */
+    glGetProgramiv(shader->program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        GST_WARNING_OBJECT (sink, "Program binary rejected");
+        glDeleteProgram (shader->program);
+        shader->program = 0;
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+GBytes *
+gl_get_shader_binary (GstGLESShader *shader, GLenum *format)
+{
+    GstGLESGetProgramBinary get_program_binary;
+    GLint length = 0;
+    gpointer binary;
+
+    if (!gl_extension_available ("GL_OES_get_program_binary"))
+        return NULL;
+
+    get_program_binary = (GstGLESGetProgramBinary)
+            eglGetProcAddress ("glGetProgramBinaryOES");
+    if (!get_program_binary)
+        return NULL;
+
+    glGetProgramiv (shader->program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0)
+        return NULL;
+
+    binary = g_malloc (length);
+    get_program_binary (shader->program, length, &length, format, binary);
+    if (glGetError () != GL_NO_ERROR) {
+        g_free (binary);
+        return NULL;
+    }
+
+    return g_bytes_new_take (binary, length);
+}
+
+gint
+gl_init_shader (GstElement *sink, GstGLESShader *shader,
+                GstGLESShaderTypes process_type)
+{
+    gint ret;
+
+    ret = gl_begin_shader (sink, shader, process_type);
+    if (ret < 0)
+        return ret;
+
+    return gl_finish_shader (sink, shader);
+}
+
 void
 gl_delete_shader(GstGLESShader *shader)
 {
@@ -28,7 +28,10 @@ typedef struct _GstGLESShader      GstGLESShader;
 
 enum _GstGLESShaderTypes {
     SHADER_DEINT_LINEAR = 0,
-    SHADER_COPY
+    SHADER_COPY,
+    SHADER_YUV_RGB,
+    SHADER_SCALE_KERNEL,
+    SHADER_COUNT
 };
 
 struct _GstGLESShader
@@ -40,6 +43,9 @@ struct _GstGLESShader
     /* standard locations, used in most shaders */
     GLint position_loc;
     GLint texcoord_loc;
+
+    /* time spent reading shader files in gl_init_shader */
+    GstClockTime read_time;
 };
 
 struct _GstGLESTexture
@@ -53,6 +59,37 @@ struct _GstGLESTexture
 gint
 gl_init_shader (GstElement *sink, GstGLESShader *shader,
                 GstGLESShaderTypes process_type);
+
+/* the two halves of gl_init_shader: begin issues compile and link without
+ * waiting for the result, finish checks it. Beginning several programs
+ * before finishing any lets a driver with parallel compile overlap them */
+gint
+gl_begin_shader (GstElement *sink, GstGLESShader *shader,
+                 GstGLESShaderTypes process_type);
+gint
+gl_finish_shader (GstElement *sink, GstGLESShader *shader);
+
+/* like gl_begin_shader, with preprocessor defines put in front of the
+ * fragment shader source, e.g. to sample another texture layout */
+gint
+gl_begin_shader_variant (GstElement *sink, GstGLESShader *shader,
+                         GstGLESShaderTypes process_type,
+                         const gchar *defines);
+
+/* begins a program from a binary retrieved with gl_get_shader_binary,
+ * returns a negative value if the binary can not be used */
+gint
+gl_begin_shader_binary (GstElement *sink, GstGLESShader *shader,
+                        GLenum format, GBytes *binary);
+
+/* the binary of a linked program, NULL if the driver can't provide one */
+GBytes *
+gl_get_shader_binary (GstGLESShader *shader, GLenum *format);
+
+/* asks the driver to compile on background threads,
+ * returns FALSE if it can't */
+gboolean
+gl_shader_parallel_compile (GstElement *sink);
 void
 gl_delete_shader (GstGLESShader *shader);
 #endif
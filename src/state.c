@@ -0,0 +1,138 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gst/gst.h>
+#include <GLES2/gl2.h>
+
+#include "state.h"
+
+/* no GL object has this name, so any binding differs from it */
+#define STATE_UNKNOWN G_MAXUINT
+
+void
+gl_state_invalidate (GstGLESState *state)
+{
+    guint i;
+
+    state->program = STATE_UNKNOWN;
+    state->active_unit = STATE_UNKNOWN;
+    for (i = 0; i < STATE_TEXTURE_UNITS; i++)
+        state->textures[i] = STATE_UNKNOWN;
+    state->framebuffer = STATE_UNKNOWN;
+    state->viewport[2] = -1;
+    state->array_buffer = STATE_UNKNOWN;
+    state->element_buffer = STATE_UNKNOWN;
+    state->attribute_buffer = STATE_UNKNOWN;
+    state->attribute_offset = 0;
+    state->attributes_enabled = FALSE;
+}
+
+void
+gl_state_use_program (GstGLESState *state, GLuint program)
+{
+    if (state->program == program)
+        return;
+
+    glUseProgram (program);
+    state->program = program;
+}
+
+void
+gl_state_bind_texture (GstGLESState *state, guint unit, GLuint texture)
+{
+    g_return_if_fail (unit < STATE_TEXTURE_UNITS);
+
+    if (state->active_unit != unit) {
+        glActiveTexture (GL_TEXTURE0 + unit);
+        state->active_unit = unit;
+    }
+
+    if (state->textures[unit] == texture)
+        return;
+
+    glBindTexture (GL_TEXTURE_2D, texture);
+    state->textures[unit] = texture;
+}
+
+void
+gl_state_bind_framebuffer (GstGLESState *state, GLuint framebuffer)
+{
+    if (state->framebuffer == framebuffer)
+        return;
+
+    glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+    state->framebuffer = framebuffer;
+}
+
+void
+gl_state_viewport (GstGLESState *state, GLint x, GLint y, GLsizei width,
+                   GLsizei height)
+{
+    if (state->viewport[0] == x && state->viewport[1] == y &&
+        state->viewport[2] == width && state->viewport[3] == height)
+        return;
+
+    glViewport (x, y, width, height);
+    state->viewport[0] = x;
+    state->viewport[1] = y;
+    state->viewport[2] = width;
+    state->viewport[3] = height;
+}
+
+void
+gl_state_bind_buffers (GstGLESState *state, GLuint array_buffer,
+                       GLuint element_buffer)
+{
+    if (state->array_buffer != array_buffer) {
+        glBindBuffer (GL_ARRAY_BUFFER, array_buffer);
+        state->array_buffer = array_buffer;
+    }
+
+    if (state->element_buffer != element_buffer) {
+        glBindBuffer (GL_ELEMENT_ARRAY_BUFFER, element_buffer);
+        state->element_buffer = element_buffer;
+    }
+}
+
+void
+gl_state_quad_attributes (GstGLESState *state, GLuint array_buffer,
+                          GLuint element_buffer, gsize offset)
+{
+    gl_state_bind_buffers (state, array_buffer, element_buffer);
+
+    if (!state->attributes_enabled) {
+        glEnableVertexAttribArray (STATE_POSITION_LOC);
+        glEnableVertexAttribArray (STATE_TEXCOORD_LOC);
+        state->attributes_enabled = TRUE;
+    }
+
+    if (state->attribute_buffer == array_buffer &&
+        state->attribute_offset == offset)
+        return;
+
+    glVertexAttribPointer (STATE_POSITION_LOC, 2, GL_FLOAT, GL_FALSE,
+                           4 * sizeof (GLfloat), (const GLvoid *) offset);
+    glVertexAttribPointer (STATE_TEXCOORD_LOC, 2, GL_FLOAT, GL_FALSE,
+                           4 * sizeof (GLfloat),
+                           (const GLvoid *) (offset + 2 * sizeof (GLfloat)));
+    state->attribute_buffer = array_buffer;
+    state->attribute_offset = offset;
+}
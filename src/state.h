@@ -0,0 +1,76 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _STATE_H__
+#define _STATE_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+
+/* attribute locations every program is linked with */
+#define STATE_POSITION_LOC 0
+#define STATE_TEXCOORD_LOC 1
+
+/* texture units the sink uses: the yuv planes, the rgb texture, the
+ * tone mapping table and the scaling weights */
+#define STATE_TEXTURE_UNITS 6
+
+typedef struct _GstGLESState       GstGLESState;
+
+/* the bindings last made on a context, so the per frame passes only call
+ * into the driver for what actually changes. Code that binds without
+ * going through the cache has to invalidate it afterwards */
+struct _GstGLESState
+{
+    GLuint program;
+    guint active_unit;
+    GLuint textures[STATE_TEXTURE_UNITS];
+    GLuint framebuffer;
+    GLint viewport[4];
+    GLuint array_buffer;
+    GLuint element_buffer;
+
+    /* where the attribute pointers were last set to. GLES 2 has no
+     * vertex array objects, so they are set again whenever a draw
+     * reads another buffer */
+    GLuint attribute_buffer;
+    gsize attribute_offset;
+    gboolean attributes_enabled;
+};
+
+/* forgets every binding, the next call of each setter reaches the GL */
+void gl_state_invalidate (GstGLESState *state);
+
+void gl_state_use_program (GstGLESState *state, GLuint program);
+void gl_state_bind_texture (GstGLESState *state, guint unit, GLuint texture);
+void gl_state_bind_framebuffer (GstGLESState *state, GLuint framebuffer);
+void gl_state_viewport (GstGLESState *state, GLint x, GLint y, GLsizei width,
+                        GLsizei height);
+void gl_state_bind_buffers (GstGLESState *state, GLuint array_buffer,
+                            GLuint element_buffer);
+
+/* binds the buffers and points the position and texture coordinate
+ * attributes at the quad from offset in the array buffer, laid out as
+ * position and texture coordinate for each corner */
+void gl_state_quad_attributes (GstGLESState *state, GLuint array_buffer,
+                               GLuint element_buffer, gsize offset);
+
+#endif
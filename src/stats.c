@@ -0,0 +1,164 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#define GST_USE_UNSTABLE_API
+#include <gst/gst.h>
+
+#include "stats.h"
+
+void
+gst_gles_stats_init (GstGLESStats *stats)
+{
+    g_mutex_init (&stats->lock);
+    gst_gles_stats_reset (stats);
+}
+
+void
+gst_gles_stats_clear (GstGLESStats *stats)
+{
+    g_mutex_clear (&stats->lock);
+}
+
+void
+gst_gles_stats_reset (GstGLESStats *stats)
+{
+    g_mutex_lock (&stats->lock);
+    stats->rendered = 0;
+    stats->dropped = 0;
+    stats->late = 0;
+    stats->window_pos = 0;
+    stats->window_fill = 0;
+    stats->upload_bytes = 0;
+    stats->upload_time = 0;
+    g_mutex_unlock (&stats->lock);
+}
+
+void
+gst_gles_stats_frame_rendered (GstGLESStats *stats, GstClockTime latency,
+                               GstClockTime presented, gsize upload_bytes,
+                               GstClockTime upload_time)
+{
+    g_mutex_lock (&stats->lock);
+    stats->rendered++;
+
+    stats->latency[stats->window_pos] = latency;
+    stats->presented[stats->window_pos] = presented;
+    stats->window_pos = (stats->window_pos + 1) % STATS_WINDOW;
+    if (stats->window_fill < STATS_WINDOW)
+        stats->window_fill++;
+
+    if (GST_CLOCK_TIME_IS_VALID (upload_time)) {
+        stats->upload_bytes += upload_bytes;
+        stats->upload_time += upload_time;
+    }
+    g_mutex_unlock (&stats->lock);
+}
+
+void
+gst_gles_stats_frame_dropped (GstGLESStats *stats)
+{
+    g_mutex_lock (&stats->lock);
+    stats->dropped++;
+    g_mutex_unlock (&stats->lock);
+}
+
+void
+gst_gles_stats_frame_late (GstGLESStats *stats)
+{
+    g_mutex_lock (&stats->lock);
+    stats->late++;
+    g_mutex_unlock (&stats->lock);
+}
+
+static gint
+compare_clock_time (gconstpointer a, gconstpointer b)
+{
+    GstClockTime ta = *(const GstClockTime *) a;
+    GstClockTime tb = *(const GstClockTime *) b;
+
+    return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* nearest rank percentile of a sorted window */
+static GstClockTime
+percentile (const GstClockTime *sorted, guint n, guint percent)
+{
+    guint rank = (n * percent + 99) / 100;
+
+    return sorted[MAX (rank, 1) - 1];
+}
+
+GstStructure *
+gst_gles_stats_get_structure (GstGLESStats *stats)
+{
+    GstClockTime sorted[STATS_WINDOW];
+    GstClockTime average = 0, p95 = 0, p99 = 0;
+    GstClockTime oldest, newest;
+    gdouble fps = 0.0;
+    guint64 bandwidth = 0;
+    GstStructure *s;
+    guint n, i;
+
+    g_mutex_lock (&stats->lock);
+    n = stats->window_fill;
+
+    if (n > 0) {
+        memcpy (sorted, stats->latency, n * sizeof (GstClockTime));
+        qsort (sorted, n, sizeof (GstClockTime), compare_clock_time);
+
+        for (i = 0; i < n; i++)
+            average += sorted[i];
+        average /= n;
+        p95 = percentile (sorted, n, 95);
+        p99 = percentile (sorted, n, 99);
+    }
+
+    if (n > 1) {
+        newest = stats->presented[(stats->window_pos + STATS_WINDOW - 1) %
+                                  STATS_WINDOW];
+        oldest = stats->presented[(stats->window_pos + STATS_WINDOW - n) %
+                                  STATS_WINDOW];
+        if (newest > oldest)
+            fps = (gdouble) (n - 1) * GST_SECOND / (newest - oldest);
+    }
+
+    if (stats->upload_time > 0)
+        bandwidth = gst_util_uint64_scale (stats->upload_bytes, GST_SECOND,
+                                           stats->upload_time);
+
+    s = gst_structure_new ("GstGLESSinkStats",
+            "rendered", G_TYPE_UINT64, stats->rendered,
+            "dropped", G_TYPE_UINT64, stats->dropped,
+            "late", G_TYPE_UINT64, stats->late,
+            "average-latency", G_TYPE_UINT64, average,
+            "p95-latency", G_TYPE_UINT64, p95,
+            "p99-latency", G_TYPE_UINT64, p99,
+            "fps", G_TYPE_DOUBLE, fps,
+            "upload-bandwidth", G_TYPE_UINT64, bandwidth,
+            NULL);
+    g_mutex_unlock (&stats->lock);
+
+    return s;
+}
@@ -0,0 +1,70 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _STATS_H__
+#define _STATS_H__
+
+#include <gst/gst.h>
+
+/* number of recent frames latency percentiles and fps are taken from */
+#define STATS_WINDOW 256
+
+typedef struct _GstGLESStats       GstGLESStats;
+
+struct _GstGLESStats
+{
+    GMutex lock;
+
+    guint64 rendered;
+    guint64 dropped;
+    guint64 late;
+
+    /* upload to present latency and swap completion time of the
+     * most recent frames */
+    GstClockTime latency[STATS_WINDOW];
+    GstClockTime presented[STATS_WINDOW];
+    guint window_pos;
+    guint window_fill;
+
+    guint64 upload_bytes;
+    GstClockTime upload_time;
+};
+
+void
+gst_gles_stats_init (GstGLESStats *stats);
+void
+gst_gles_stats_clear (GstGLESStats *stats);
+void
+gst_gles_stats_reset (GstGLESStats *stats);
+
+void
+gst_gles_stats_frame_rendered (GstGLESStats *stats, GstClockTime latency,
+                               GstClockTime presented, gsize upload_bytes,
+                               GstClockTime upload_time);
+void
+gst_gles_stats_frame_dropped (GstGLESStats *stats);
+void
+gst_gles_stats_frame_late (GstGLESStats *stats);
+
+/* returns a new GstGLESSinkStats structure */
+GstStructure *
+gst_gles_stats_get_structure (GstGLESStats *stats);
+#endif
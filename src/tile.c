@@ -0,0 +1,160 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <GLES2/gl2.h>
+
+#include "tile.h"
+#include "pool.h"
+
+#if GST_CHECK_VERSION(1, 0, 0)
+
+static GLuint
+gl_tile_texture (GLuint tex_filter)
+{
+    GLuint tex_id = 0;
+
+    glGenTextures (1, &tex_id);
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex_filter);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, tex_filter);
+
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    return tex_id;
+}
+
+static void
+gl_tile_alloc_plane (GLuint tex_id, GLenum format, gint width, gint height)
+{
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+    glTexImage2D (GL_TEXTURE_2D, 0, format, width, height, 0, format,
+                  GL_UNSIGNED_BYTE, NULL);
+}
+
+void
+gl_tile_alloc (GstGLESTile *tile, gint width, gint height)
+{
+    if (!tile->framebuffer) {
+        glGenFramebuffers (1, &tile->framebuffer);
+        tile->y_tex.id = gl_tile_texture (GL_NEAREST);
+        tile->u_tex.id = gl_tile_texture (GL_NEAREST);
+        tile->v_tex.id = gl_tile_texture (GL_NEAREST);
+        tile->rgb_tex.id = gl_tile_texture (GL_LINEAR);
+    }
+
+    /* odd sizes round the chroma planes up, like GST_VIDEO_FRAME_COMP_WIDTH
+     * and GST_VIDEO_FRAME_COMP_HEIGHT of the uploaded frames */
+    gl_tile_alloc_plane (tile->y_tex.id, GL_LUMINANCE, width, height);
+    gl_tile_alloc_plane (tile->u_tex.id, GL_LUMINANCE, (width + 1) / 2,
+                         (height + 1) / 2);
+    gl_tile_alloc_plane (tile->v_tex.id, GL_LUMINANCE, (width + 1) / 2,
+                         (height + 1) / 2);
+    gl_tile_alloc_plane (tile->rgb_tex.id, GL_RGB, width, height);
+
+    glBindFramebuffer (GL_FRAMEBUFFER, tile->framebuffer);
+    glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_TEXTURE_2D, tile->rgb_tex.id, 0);
+
+    tile->width = width;
+    tile->height = height;
+    tile->valid = FALSE;
+}
+
+void
+gl_tile_free (GstGLESTile *tile)
+{
+    const GLuint textures[] = {
+        tile->y_tex.id,
+        tile->u_tex.id,
+        tile->v_tex.id,
+        tile->rgb_tex.id
+    };
+
+    if (tile->framebuffer) {
+        glDeleteFramebuffers (1, &tile->framebuffer);
+        glDeleteTextures (G_N_ELEMENTS (textures), textures);
+    }
+    memset (tile, 0, sizeof (GstGLESTile));
+}
+
+/* uploads one plane, row by row if it is padded */
+static void
+gl_tile_upload_plane (GLuint tex_id, const guint8 *data, gint width,
+                      gint height, gint stride)
+{
+    gint i;
+
+    glBindTexture (GL_TEXTURE_2D, tex_id);
+    if (stride == width) {
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, width, height,
+                         GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+        return;
+    }
+
+    for (i = 0; i < height; i++)
+        glTexSubImage2D (GL_TEXTURE_2D, 0, 0, i, width, 1, GL_LUMINANCE,
+                         GL_UNSIGNED_BYTE, data + i * stride);
+}
+
+void
+gl_tile_upload (GstGLESTile *tile, GstVideoFrame *frame)
+{
+    const GLuint *textures[] = {
+        &tile->y_tex.id, &tile->u_tex.id, &tile->v_tex.id
+    };
+    gint width = GST_VIDEO_FRAME_WIDTH (frame);
+    gint height = GST_VIDEO_FRAME_HEIGHT (frame);
+    guint i;
+
+    if (tile->width != width || tile->height != height)
+        gl_tile_alloc (tile, width, height);
+
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+    for (i = 0; i < 3; i++) {
+        glActiveTexture (GL_TEXTURE0 + i);
+        gl_tile_upload_plane (*textures[i],
+                              GST_VIDEO_FRAME_PLANE_DATA (frame, i),
+                              GST_VIDEO_FRAME_COMP_WIDTH (frame, i),
+                              GST_VIDEO_FRAME_COMP_HEIGHT (frame, i),
+                              GST_VIDEO_FRAME_PLANE_STRIDE (frame, i));
+    }
+}
+
+void
+gl_tile_render (GstGLESTile *tile, GstGLESShader *shader,
+                GLuint vbo, GLuint ibo)
+{
+    glBindFramebuffer (GL_FRAMEBUFFER, tile->framebuffer);
+    glViewport (0, 0, tile->width, tile->height);
+    glUseProgram (shader->program);
+
+    gl_draw_quad (shader, vbo, ibo);
+
+    tile->valid = TRUE;
+}
+
+#endif
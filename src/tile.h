@@ -0,0 +1,67 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _TILE_H__
+#define _TILE_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#include "shader.h"
+
+typedef struct _GstGLESTile        GstGLESTile;
+
+/* textures and framebuffer that turn one I420 stream into an rgb
+ * texture, used by the elements that render offscreen */
+struct _GstGLESTile
+{
+    GstGLESTexture y_tex;
+    GstGLESTexture u_tex;
+    GstGLESTexture v_tex;
+    GstGLESTexture rgb_tex;
+    GLuint framebuffer;
+
+    /* size the textures are allocated for */
+    gint width;
+    gint height;
+    /* the rgb texture holds a converted frame */
+    gboolean valid;
+};
+
+#if GST_CHECK_VERSION(1, 0, 0)
+
+/* (re)allocates the textures for a new frame size */
+void gl_tile_alloc (GstGLESTile *tile, gint width, gint height);
+void gl_tile_free (GstGLESTile *tile);
+
+/* uploads the planes of the frame to texture units 0 to 2, the textures
+ * are reallocated if the frame size changed */
+void gl_tile_upload (GstGLESTile *tile, GstVideoFrame *frame);
+
+/* draws the uploaded planes with a yuv program into the rgb texture,
+ * the samplers of the program have to use units 0 to 2 */
+void gl_tile_render (GstGLESTile *tile, GstGLESShader *shader,
+                     GLuint vbo, GLuint ibo);
+
+#endif
+
+#endif
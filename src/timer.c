@@ -0,0 +1,273 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#define GST_USE_UNSTABLE_API
+#include <gst/gst.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include "timer.h"
+
+/* FIXME: Should be part of the GLES headers */
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT                                     0x88BF
+#endif
+#ifndef GL_QUERY_RESULT_EXT
+#define GL_QUERY_RESULT_EXT                                     0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE_EXT
+#define GL_QUERY_RESULT_AVAILABLE_EXT                           0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT                                     0x8FBB
+#endif
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+static const gchar* stage_names[] = {
+    "map", /* STAGE_MAP */
+    "upload", /* STAGE_UPLOAD */
+    "fbo", /* STAGE_FBO */
+    "onscreen", /* STAGE_ONSCREEN */
+    "swap" /* STAGE_SWAP */
+};
+
+/* mapping and swapping do not submit any gl commands to time */
+static gboolean
+stage_has_gpu_work (GstGLESStage stage)
+{
+    return stage == STAGE_UPLOAD || stage == STAGE_FBO ||
+           stage == STAGE_ONSCREEN;
+}
+
+static gboolean
+gl_extension_available (const gchar *extension)
+{
+    const gchar *gl_extensions = (gchar*)glGetString(GL_EXTENSIONS);
+    return (gl_extensions &&
+            g_strstr_len(gl_extensions, -1, extension) != NULL);
+}
+
+void
+gl_timer_init (GstElement *sink, GstGLESTimer *timer)
+{
+    guint i;
+
+    memset (timer, 0, sizeof (GstGLESTimer));
+    for (i = 0; i < STAGE_COUNT; i++) {
+        timer->start[i] = GST_CLOCK_TIME_NONE;
+        timer->cpu[i] = GST_CLOCK_TIME_NONE;
+        timer->gpu_time[i] = GST_CLOCK_TIME_NONE;
+    }
+
+    if (!gl_extension_available ("GL_EXT_disjoint_timer_query")) {
+        GST_INFO_OBJECT (sink, "No timer queries, using cpu timestamps");
+        return;
+    }
+
+    timer->gen_queries = (GstGLESGenQueries)
+            eglGetProcAddress ("glGenQueriesEXT");
+    timer->delete_queries = (GstGLESDeleteQueries)
+            eglGetProcAddress ("glDeleteQueriesEXT");
+    timer->begin_query = (GstGLESBeginQuery)
+            eglGetProcAddress ("glBeginQueryEXT");
+    timer->end_query = (GstGLESEndQuery)
+            eglGetProcAddress ("glEndQueryEXT");
+    timer->get_query_objectuiv = (GstGLESGetQueryObjectuiv)
+            eglGetProcAddress ("glGetQueryObjectuivEXT");
+    timer->get_query_objectui64v = (GstGLESGetQueryObjectui64v)
+            eglGetProcAddress ("glGetQueryObjectui64vEXT");
+
+    if (!timer->gen_queries || !timer->delete_queries ||
+        !timer->begin_query || !timer->end_query ||
+        !timer->get_query_objectuiv || !timer->get_query_objectui64v) {
+        GST_WARNING_OBJECT (sink, "Timer query entry points missing, "
+                            "using cpu timestamps");
+        return;
+    }
+
+    for (i = 0; i < TIMER_FRAMES; i++)
+        timer->gen_queries (STAGE_COUNT, timer->queries[i]);
+
+    timer->gpu = TRUE;
+    GST_INFO_OBJECT (sink, "Using GL_EXT_disjoint_timer_query");
+}
+
+void
+gl_timer_close (GstGLESTimer *timer)
+{
+    guint i;
+
+    if (timer->gpu) {
+        for (i = 0; i < TIMER_FRAMES; i++)
+            timer->delete_queries (STAGE_COUNT, timer->queries[i]);
+    }
+
+    timer->gpu = FALSE;
+    timer->running = FALSE;
+}
+
+static void
+gl_timer_collect_slot (GstGLESTimer *timer, guint slot)
+{
+    guint64 elapsed;
+    GLuint available = 0;
+    guint i;
+
+    /* queries finish in order, the last one tells about all */
+    timer->get_query_objectuiv (timer->queries[slot][STAGE_ONSCREEN],
+                                GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+    if (!available)
+        return;
+
+    for (i = 0; i < STAGE_COUNT; i++) {
+        if (!stage_has_gpu_work (i))
+            continue;
+
+        timer->get_query_objectui64v (timer->queries[slot][i],
+                                      GL_QUERY_RESULT_EXT, &elapsed);
+        timer->gpu_time[i] = elapsed;
+    }
+
+    timer->pending[slot] = FALSE;
+    timer->gpu_frames++;
+}
+
+void
+gl_timer_begin_frame (GstGLESTimer *timer)
+{
+    guint slot = timer->frame % TIMER_FRAMES;
+    GLint disjoint = 0;
+    guint i;
+
+    timer->running = TRUE;
+    if (!timer->gpu)
+        return;
+
+    /* results are meaningless if the gpu clock jumped meanwhile */
+    glGetIntegerv (GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+        memset (timer->pending, 0, sizeof (timer->pending));
+
+    /* oldest frame first, so the newest results win */
+    for (i = 0; i < TIMER_FRAMES; i++) {
+        guint n = (slot + i) % TIMER_FRAMES;
+        if (timer->pending[n])
+            gl_timer_collect_slot (timer, n);
+    }
+
+    /* rather lose a measurement than wait for the gpu */
+    timer->pending[slot] = FALSE;
+}
+
+void
+gl_timer_end_frame (GstGLESTimer *timer)
+{
+    if (!timer->running)
+        return;
+
+    if (timer->gpu)
+        timer->pending[timer->frame % TIMER_FRAMES] = TRUE;
+
+    timer->frame++;
+    timer->running = FALSE;
+}
+
+void
+gl_timer_begin (GstGLESTimer *timer, GstGLESStage stage)
+{
+    if (!timer->running)
+        return;
+
+    timer->start[stage] = gst_util_get_timestamp ();
+    if (timer->gpu && stage_has_gpu_work (stage))
+        timer->begin_query (GL_TIME_ELAPSED_EXT,
+                            timer->queries[timer->frame % TIMER_FRAMES][stage]);
+}
+
+void
+gl_timer_end (GstGLESTimer *timer, GstGLESStage stage)
+{
+    if (!timer->running)
+        return;
+
+    if (timer->gpu && stage_has_gpu_work (stage))
+        timer->end_query (GL_TIME_ELAPSED_EXT);
+    timer->cpu[stage] = gst_util_get_timestamp () - timer->start[stage];
+}
+
+GstClockTime
+gl_timer_gpu_cost (GstGLESTimer *timer)
+{
+    GstClockTime cost = 0;
+    guint i;
+
+    for (i = 0; i < STAGE_COUNT; i++) {
+        if (!stage_has_gpu_work (i))
+            continue;
+
+        if (timer->gpu && GST_CLOCK_TIME_IS_VALID (timer->gpu_time[i]))
+            cost += timer->gpu_time[i];
+        else if (GST_CLOCK_TIME_IS_VALID (timer->cpu[i]))
+            cost += timer->cpu[i];
+    }
+
+    return cost;
+}
+
+const gchar *
+gl_timer_stage_name (GstGLESStage stage)
+{
+    return stage_names[stage];
+}
+
+GstStructure *
+gl_timer_get_structure (GstGLESTimer *timer)
+{
+    GstStructure *s;
+    guint i;
+
+    s = gst_structure_new ("GstGLESSinkTimings",
+            "gpu", G_TYPE_BOOLEAN, timer->gpu,
+            "gpu-frames", G_TYPE_UINT64, timer->gpu_frames,
+            NULL);
+
+    for (i = 0; i < STAGE_COUNT; i++) {
+        gchar *name;
+
+        name = g_strdup_printf ("%s-cpu", stage_names[i]);
+        gst_structure_set (s, name, G_TYPE_UINT64, timer->cpu[i], NULL);
+        g_free (name);
+
+        if (!stage_has_gpu_work (i))
+            continue;
+
+        name = g_strdup_printf ("%s-gpu", stage_names[i]);
+        gst_structure_set (s, name, G_TYPE_UINT64, timer->gpu_time[i], NULL);
+        g_free (name);
+    }
+
+    return s;
+}
@@ -0,0 +1,109 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _TIMER_H__
+#define _TIMER_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+
+/* frames whose gpu timings may still be in flight */
+#define TIMER_FRAMES 4
+
+typedef enum _GstGLESStage         GstGLESStage;
+typedef struct _GstGLESTimer       GstGLESTimer;
+
+typedef void (GL_APIENTRY *GstGLESGenQueries) (GLsizei n, GLuint *ids);
+typedef void (GL_APIENTRY *GstGLESDeleteQueries) (GLsizei n,
+                                                  const GLuint *ids);
+typedef void (GL_APIENTRY *GstGLESBeginQuery) (GLenum target, GLuint id);
+typedef void (GL_APIENTRY *GstGLESEndQuery) (GLenum target);
+typedef void (GL_APIENTRY *GstGLESGetQueryObjectuiv) (GLuint id, GLenum pname,
+                                                      GLuint *params);
+typedef void (GL_APIENTRY *GstGLESGetQueryObjectui64v) (GLuint id,
+                                                        GLenum pname,
+                                                        guint64 *params);
+
+enum _GstGLESStage {
+    STAGE_MAP = 0,
+    STAGE_UPLOAD,
+    STAGE_FBO,
+    STAGE_ONSCREEN,
+    STAGE_SWAP,
+    STAGE_COUNT
+};
+
+struct _GstGLESTimer
+{
+    /* GL_EXT_disjoint_timer_query is available */
+    gboolean gpu;
+    /* stages are only timed between begin and end of a frame */
+    gboolean running;
+
+    GstGLESGenQueries gen_queries;
+    GstGLESDeleteQueries delete_queries;
+    GstGLESBeginQuery begin_query;
+    GstGLESEndQuery end_query;
+    GstGLESGetQueryObjectuiv get_query_objectuiv;
+    GstGLESGetQueryObjectui64v get_query_objectui64v;
+
+    /* ring of query objects, one set per frame in flight */
+    GLuint queries[TIMER_FRAMES][STAGE_COUNT];
+    gboolean pending[TIMER_FRAMES];
+    guint frame;
+
+    /* monotonic start of each stage in the last frame */
+    GstClockTime start[STAGE_COUNT];
+
+    /* cpu times of the last frame and the most recent gpu times, which
+     * lag a few frames behind. stages without gpu work stay invalid */
+    GstClockTime cpu[STAGE_COUNT];
+    GstClockTime gpu_time[STAGE_COUNT];
+    guint64 gpu_frames;
+};
+
+/* checks for timer query support, needs a current context */
+void
+gl_timer_init (GstElement *sink, GstGLESTimer *timer);
+void
+gl_timer_close (GstGLESTimer *timer);
+
+/* collects finished gpu timings without waiting for the gpu */
+void
+gl_timer_begin_frame (GstGLESTimer *timer);
+void
+gl_timer_end_frame (GstGLESTimer *timer);
+
+void
+gl_timer_begin (GstGLESTimer *timer, GstGLESStage stage);
+void
+gl_timer_end (GstGLESTimer *timer, GstGLESStage stage);
+
+/* gpu time of the last measured frame, cpu time if not available */
+GstClockTime
+gl_timer_gpu_cost (GstGLESTimer *timer);
+
+const gchar *
+gl_timer_stage_name (GstGLESStage stage);
+
+GstStructure *
+gl_timer_get_structure (GstGLESTimer *timer);
+#endif
@@ -0,0 +1,187 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <math.h>
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <GLES2/gl2.h>
+
+#include "tonemap.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+/* SMPTE ST 2084 constants */
+#define PQ_M1 (2610.0 / 16384.0)
+#define PQ_M2 (2523.0 / 4096.0 * 128.0)
+#define PQ_C1 (3424.0 / 4096.0)
+#define PQ_C2 (2413.0 / 4096.0 * 32.0)
+#define PQ_C3 (2392.0 / 4096.0 * 32.0)
+
+/* ARIB STD-B67 constants and the system gamma of a 1000 cd/m² display */
+#define HLG_A 0.17883277
+#define HLG_B 0.28466892
+#define HLG_C 0.55991073
+#define HLG_GAMMA 1.2
+#define HLG_DISPLAY_PEAK 1000.0
+
+/* by YUV_BT2020, TONE_MAP and GAMUT_BT2020, the gamut is only converted
+ * in linear light, so only together with the tone mapping */
+static const gchar *color_defines[] = {
+    NULL,
+    "#define YUV_BT2020\n",
+    "#define TONE_MAP\n",
+    "#define YUV_BT2020\n#define TONE_MAP\n",
+    NULL,
+    "#define YUV_BT2020\n",
+    "#define TONE_MAP\n#define GAMUT_BT2020\n",
+    "#define YUV_BT2020\n#define TONE_MAP\n#define GAMUT_BT2020\n"
+};
+
+void
+gst_gles_color_from_caps (GstGLESColor *color, GstCaps *caps)
+{
+#if GST_CHECK_VERSION(1, 18, 0)
+    GstVideoContentLightLevel cll;
+    GstVideoMasteringDisplayInfo mdi;
+    GstVideoInfo info;
+#endif
+
+    color->tone_map = TONE_MAP_NONE;
+    color->peak = TONE_MAP_DEFAULT_PEAK;
+    color->matrix_bt2020 = FALSE;
+    color->primaries_bt2020 = FALSE;
+
+#if GST_CHECK_VERSION(1, 18, 0)
+    if (!gst_video_info_from_caps (&info, caps))
+        return;
+
+    color->matrix_bt2020 =
+            info.colorimetry.matrix == GST_VIDEO_COLOR_MATRIX_BT2020;
+    color->primaries_bt2020 =
+            info.colorimetry.primaries == GST_VIDEO_COLOR_PRIMARIES_BT2020;
+
+    if (info.colorimetry.transfer == GST_VIDEO_TRANSFER_SMPTE2084)
+        color->tone_map = TONE_MAP_PQ;
+    else if (info.colorimetry.transfer == GST_VIDEO_TRANSFER_ARIB_STD_B67)
+        color->tone_map = TONE_MAP_HLG;
+
+    /* the brightest pixel of the content, else of the mastering
+     * display */
+    if (gst_video_content_light_level_from_caps (&cll, caps) &&
+        cll.max_content_light_level > 0)
+        color->peak = cll.max_content_light_level;
+    else if (gst_video_mastering_display_info_from_caps (&mdi, caps) &&
+             mdi.max_display_mastering_luminance > 0)
+        color->peak = mdi.max_display_mastering_luminance / 10000.0;
+
+    GST_DEBUG ("Tone map %d, peak %.0f cd/m², BT.2020 matrix %d, "
+               "primaries %d", color->tone_map, color->peak,
+               color->matrix_bt2020, color->primaries_bt2020);
+#endif
+}
+
+const gchar *
+gst_gles_color_shader_defines (const GstGLESColor *color)
+{
+    guint index = (color->matrix_bt2020 ? 1 : 0) |
+                  (color->tone_map != TONE_MAP_NONE ? 2 : 0) |
+                  (color->primaries_bt2020 ? 4 : 0);
+
+    return color_defines[index];
+}
+
+/* coded value to cd/m² */
+static gdouble
+pq_eotf (gdouble x)
+{
+    gdouble e = pow (x, 1.0 / PQ_M2);
+    return 10000.0 * pow (MAX (e - PQ_C1, 0.0) / (PQ_C2 - PQ_C3 * e),
+                          1.0 / PQ_M1);
+}
+
+/* coded value to cd/m² on the reference display. The system gamma is
+ * applied per channel, close enough for the tone mapping that follows */
+static gdouble
+hlg_eotf (gdouble x)
+{
+    gdouble scene;
+
+    if (x <= 0.5)
+        scene = x * x / 3.0;
+    else
+        scene = (exp ((x - HLG_C) / HLG_A) + HLG_B) / 12.0;
+
+    return HLG_DISPLAY_PEAK * pow (scene, HLG_GAMMA);
+}
+
+void
+gst_gles_color_build_lut (const GstGLESColor *color, guint16 *lut)
+{
+    gdouble peak = color->peak;
+    gdouble white;
+    guint i;
+
+    if (color->tone_map == TONE_MAP_HLG)
+        peak = MIN (peak, HLG_DISPLAY_PEAK);
+
+    /* extended Reinhard curve, which maps the peak to SDR white and
+     * leaves dark parts almost linear */
+    white = MAX (peak / TONE_MAP_SDR_WHITE, 1.0);
+
+    for (i = 0; i < TONE_MAP_LUT_SIZE; i++) {
+        gdouble x = (gdouble) i / (TONE_MAP_LUT_SIZE - 1);
+        gdouble l;
+
+        l = color->tone_map == TONE_MAP_HLG ? hlg_eotf (x) : pq_eotf (x);
+        l /= TONE_MAP_SDR_WHITE;
+        l = l * (1.0 + l / (white * white)) / (1.0 + l);
+
+        lut[i] = CLAMP (l, 0.0, 1.0) * 65535.0 + 0.5;
+    }
+}
+
+void
+gl_tone_map_upload (const GstGLESColor *color, GLuint *tex_id)
+{
+    guint16 lut[TONE_MAP_LUT_SIZE];
+
+    gst_gles_color_build_lut (color, lut);
+
+    if (!*tex_id) {
+        glGenTextures (1, tex_id);
+        glBindTexture (GL_TEXTURE_2D, *tex_id);
+
+        /* byte pairs can't be interpolated */
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    } else {
+        glBindTexture (GL_TEXTURE_2D, *tex_id);
+    }
+
+    /* little endian, so the low byte lands in luminance */
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, TONE_MAP_LUT_SIZE, 1,
+                  0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, lut);
+}
@@ -0,0 +1,72 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _TONEMAP_H__
+#define _TONEMAP_H__
+
+#include <GLES2/gl2.h>
+#include <gst/gst.h>
+
+/* entries of the lookup table, one per 10 bit code value */
+#define TONE_MAP_LUT_SIZE 1024
+
+/* brightness SDR white is shown at, after BT.2408 */
+#define TONE_MAP_SDR_WHITE 203.0
+
+/* peak brightness assumed if the caps don't tell */
+#define TONE_MAP_DEFAULT_PEAK 1000.0
+
+typedef enum _GstGLESToneMap      GstGLESToneMap;
+typedef struct _GstGLESColor      GstGLESColor;
+
+enum _GstGLESToneMap {
+    TONE_MAP_NONE = 0,
+    TONE_MAP_PQ,
+    TONE_MAP_HLG
+};
+
+/* colorimetry of the stream, as far as the conversion cares */
+struct _GstGLESColor
+{
+    GstGLESToneMap tone_map;
+    /* brightest pixel of the content in cd/m² */
+    gdouble peak;
+    /* yuv uses the BT.2020 matrix, rgb the BT.2020 primaries */
+    gboolean matrix_bt2020;
+    gboolean primaries_bt2020;
+};
+
+/* reads the colorimetry from the caps, every field stays at its SDR
+ * default for caps without one */
+void gst_gles_color_from_caps (GstGLESColor *color, GstCaps *caps);
+
+/* defines the yuv programs need for the colorimetry, NULL for none */
+const gchar *gst_gles_color_shader_defines (const GstGLESColor *color);
+
+/* fills a table mapping a PQ or HLG coded value to tone mapped linear
+ * light in 0..65535, where 65535 is SDR white */
+void gst_gles_color_build_lut (const GstGLESColor *color, guint16 *lut);
+
+/* (re)creates the lookup table texture, stored as 16 bit values split
+ * into luminance and alpha */
+void gl_tone_map_upload (const GstGLESColor *color, GLuint *tex_id);
+
+#endif
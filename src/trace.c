@@ -0,0 +1,173 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <glib.h>
+
+#define GST_USE_UNSTABLE_API
+#include <gst/gst.h>
+
+#include "trace.h"
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+#if GST_CHECK_VERSION(1, 8, 0)
+static GstTracerRecord *stage_record;
+/* the records are logged here, tracers only see them at TRACE level */
+static GstDebugCategory *tracer_category;
+#endif
+
+void
+gst_gles_trace_register (void)
+{
+#if GST_CHECK_VERSION(1, 8, 0)
+    stage_record = gst_tracer_record_new ("glessink-stage.class",
+            "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+                "type", G_TYPE_GTYPE, G_TYPE_STRING,
+                "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+                GST_TRACER_VALUE_SCOPE_ELEMENT,
+                NULL),
+            "stage", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+                "type", G_TYPE_GTYPE, G_TYPE_STRING,
+                "description", G_TYPE_STRING, "render stage",
+                NULL),
+            "thread-id", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+                "type", G_TYPE_GTYPE, G_TYPE_INT,
+                "description", G_TYPE_STRING, "thread the stage ran on",
+                NULL),
+            "start", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+                "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+                "description", G_TYPE_STRING, "monotonic start time",
+                NULL),
+            "duration", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+                "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+                "description", G_TYPE_STRING, "time spent in the stage",
+                NULL),
+            NULL);
+    GST_OBJECT_FLAG_SET (stage_record, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+    GST_DEBUG_CATEGORY_GET (tracer_category, "GST_TRACER");
+#endif
+}
+
+void
+gst_gles_trace_init (GstGLESTrace *trace)
+{
+    g_mutex_init (&trace->lock);
+    trace->file = NULL;
+    trace->pid = getpid ();
+}
+
+void
+gst_gles_trace_clear (GstGLESTrace *trace)
+{
+    gst_gles_trace_close (trace);
+    g_mutex_clear (&trace->lock);
+}
+
+gboolean
+gst_gles_trace_open (GstGLESTrace *trace, const gchar *filename)
+{
+    FILE *file;
+
+    gst_gles_trace_close (trace);
+
+    file = fopen (filename, "w");
+    if (!file)
+        return FALSE;
+
+    fputs ("[\n", file);
+
+    g_mutex_lock (&trace->lock);
+    trace->file = file;
+    trace->first_event = TRUE;
+    g_mutex_unlock (&trace->lock);
+
+    return TRUE;
+}
+
+void
+gst_gles_trace_close (GstGLESTrace *trace)
+{
+    g_mutex_lock (&trace->lock);
+    if (trace->file) {
+        fputs ("\n]\n", trace->file);
+        fclose (trace->file);
+        trace->file = NULL;
+    }
+    g_mutex_unlock (&trace->lock);
+}
+
+static gboolean
+gst_gles_trace_records_enabled (void)
+{
+#if GST_CHECK_VERSION(1, 8, 0)
+    return tracer_category &&
+           gst_debug_category_get_threshold (tracer_category) >=
+           GST_LEVEL_TRACE;
+#else
+    return FALSE;
+#endif
+}
+
+gboolean
+gst_gles_trace_enabled (GstGLESTrace *trace)
+{
+    /* unlocked, a file opened or closed meanwhile only moves the first
+     * or the last event */
+    return trace->file || gst_gles_trace_records_enabled ();
+}
+
+void
+gst_gles_trace_stage (GstGLESTrace *trace, GstElement *element,
+                      const gchar *stage, GstClockTime start,
+                      GstClockTime duration)
+{
+    gint tid;
+
+    if (!GST_CLOCK_TIME_IS_VALID (start) ||
+        !GST_CLOCK_TIME_IS_VALID (duration) ||
+        !gst_gles_trace_enabled (trace))
+        return;
+
+    tid = syscall (SYS_gettid);
+
+#if GST_CHECK_VERSION(1, 8, 0)
+    if (gst_gles_trace_records_enabled ())
+        gst_tracer_record_log (stage_record, GST_OBJECT_NAME (element),
+                               stage, tid, start, duration);
+#endif
+
+    g_mutex_lock (&trace->lock);
+    if (trace->file) {
+        /* complete events, times in microseconds */
+        fprintf (trace->file, "%s{\"name\":\"%s\",\"cat\":\"glessink\","
+                 "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,"
+                 "\"tid\":%d,\"args\":{\"element\":\"%s\"}}",
+                 trace->first_event ? "" : ",\n", stage,
+                 start / 1000.0, duration / 1000.0, trace->pid, tid,
+                 GST_OBJECT_NAME (element));
+        trace->first_event = FALSE;
+    }
+    g_mutex_unlock (&trace->lock);
+}
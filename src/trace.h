@@ -0,0 +1,68 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _TRACE_H__
+#define _TRACE_H__
+
+#include <stdio.h>
+#include <gst/gst.h>
+
+typedef struct _GstGLESTrace       GstGLESTrace;
+
+/*
+ * Render stage events, logged as GstTracerRecord (GStreamer 1.8 and
+ * later) and optionally written to a chrome trace-event JSON file.
+ */
+struct _GstGLESTrace
+{
+    GMutex lock;
+    FILE *file;
+    gboolean first_event;
+    gint pid;
+};
+
+/* registers the tracer record, call once from plugin_init */
+void
+gst_gles_trace_register (void);
+
+void
+gst_gles_trace_init (GstGLESTrace *trace);
+void
+gst_gles_trace_clear (GstGLESTrace *trace);
+
+/* starts a new JSON file, returns FALSE if it can't be created */
+gboolean
+gst_gles_trace_open (GstGLESTrace *trace, const gchar *filename);
+void
+gst_gles_trace_close (GstGLESTrace *trace);
+
+/* whether a tracer or a trace file takes the stages, callers may skip
+ * collecting them otherwise */
+gboolean
+gst_gles_trace_enabled (GstGLESTrace *trace);
+
+/* logs a stage of element that started at the monotonic time start and
+ * took duration, both as returned by gst_util_get_timestamp() */
+void
+gst_gles_trace_stage (GstGLESTrace *trace, GstElement *element,
+                      const gchar *stage, GstClockTime start,
+                      GstClockTime duration);
+#endif
@@ -0,0 +1,387 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <X11/Xlib.h>
+
+#include "window.h"
+
+/* FIXME: Should be part of the EGL headers */
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA                           0x31DD
+#endif
+
+typedef EGLDisplay (EGLAPIENTRY *GstGLESGetPlatformDisplay) (
+        EGLenum platform, void *native_display, const EGLint *attribs);
+
+GST_DEBUG_CATEGORY_EXTERN (gst_gles_sink_debug);
+#define GST_CAT_DEFAULT gst_gles_sink_debug
+
+#define X11_EVENT_MASK (StructureNotifyMask | ExposureMask | \
+                        VisibilityChangeMask | PointerMotionMask | \
+                        KeyPressMask | KeyReleaseMask)
+
+GType
+gst_gles_backend_get_type (void)
+{
+    static volatile gsize backend_type = 0;
+    static const GEnumValue backends[] = {
+        { GST_GLES_BACKEND_X11, "X11 window", "x11" },
+        { GST_GLES_BACKEND_PBUFFER, "Offscreen EGL pbuffer", "pbuffer" },
+        { GST_GLES_BACKEND_SURFACELESS,
+          "Offscreen, without a display (EGL_MESA_platform_surfaceless)",
+          "surfaceless" },
+        { 0, NULL, NULL }
+    };
+
+    if (g_once_init_enter (&backend_type)) {
+        GType tmp = g_enum_register_static ("GstGLESBackend", backends);
+        g_once_init_leave (&backend_type, tmp);
+    }
+
+    return (GType) backend_type;
+}
+
+/* X11 */
+
+static EGLDisplay
+x11_open_display (gpointer *native)
+{
+    Display *display = XOpenDisplay (NULL);
+
+    if (!display) {
+        GST_ERROR ("Could not create X display");
+        return EGL_NO_DISPLAY;
+    }
+
+    *native = display;
+    return eglGetDisplay ((EGLNativeDisplayType) display);
+}
+
+static void
+x11_close_display (gpointer native)
+{
+    XCloseDisplay ((Display *) native);
+}
+
+static gint
+x11_open (GstGLESWindow *window, gpointer native, const gchar *title)
+{
+    Window root;
+    XSetWindowAttributes swa;
+    XWMHints hints;
+
+    /* the connection is shared by all instances in the pool */
+    window->display = native;
+
+    XLockDisplay (window->display);
+    root = DefaultRootWindow (window->display);
+    swa.event_mask =
+            StructureNotifyMask | ExposureMask | VisibilityChangeMask;
+
+    if (!window->window) {
+        window->window = XCreateWindow (
+                    window->display, root,
+                    0, 0, window->width, window->height, 0,
+                    CopyFromParent, InputOutput,
+                    CopyFromParent, CWEventMask,
+                    &swa);
+
+        XSetWindowBackgroundPixmap (window->display, window->window,
+                                    None);
+
+        hints.input = True;
+        hints.flags = InputHint;
+        XSetWMHints(window->display, window->window, &hints);
+
+        XMapWindow (window->display, window->window);
+        XStoreName (window->display, window->window, title);
+    } else {
+        guint border, depth;
+        int x, y;
+        /* change event mask, so we get resize notifications */
+        XSelectInput (window->display, window->window,
+                      ExposureMask | StructureNotifyMask |
+                      PointerMotionMask | KeyPressMask |
+                      KeyReleaseMask);
+
+        /* retrieve the current window geometry */
+        XGetGeometry (window->display, window->window, &root,
+                      &x, &y, (uint*)&window->width,
+                      (uint*)&window->height, &border, &depth);
+    }
+
+    XUnlockDisplay (window->display);
+
+    return 0;
+}
+
+static EGLSurface
+x11_create_surface (GstGLESWindow *window, EGLDisplay display,
+                    EGLConfig config)
+{
+    return eglCreateWindowSurface (display, config, window->window, NULL);
+}
+
+static gboolean
+x11_handle_events (GstGLESWindow *window)
+{
+    gboolean resized = FALSE;
+    XEvent  xev;
+
+    /* only take the events of our window off the shared connection */
+    XLockDisplay (window->display);
+    while (XCheckWindowEvent (window->display, window->window,
+                              X11_EVENT_MASK, &xev)) {
+        switch (xev.type) {
+        case ConfigureNotify:
+            GST_DEBUG("XConfigure* Event: wxh: %dx%d",
+                      xev.xconfigure.width,
+                      xev.xconfigure.height);
+            window->width = xev.xconfigure.width;
+            window->height = xev.xconfigure.height;
+            resized = TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+    XUnlockDisplay (window->display);
+
+    return resized;
+}
+
+static void
+x11_close (GstGLESWindow *window)
+{
+    XLockDisplay (window->display);
+
+    /* only destroy the window if we created it, windows
+      owned by the application stay untouched */
+    if (!window->external_window) {
+        XDestroyWindow (window->display, window->window);
+        window->window = 0;
+    } else
+        XSelectInput (window->display, window->window, 0);
+
+    XSync (window->display, FALSE);
+    XUnlockDisplay (window->display);
+}
+
+/* EGL pbuffer */
+
+static EGLDisplay
+pbuffer_open_display (gpointer *native)
+{
+    return eglGetDisplay (EGL_DEFAULT_DISPLAY);
+}
+
+static EGLSurface
+pbuffer_create_surface (GstGLESWindow *window, EGLDisplay display,
+                        EGLConfig config)
+{
+    const EGLint surface_attribs[] =
+    {
+        EGL_WIDTH, window->width,
+        EGL_HEIGHT, window->height,
+        EGL_NONE
+    };
+
+    return eglCreatePbufferSurface (display, config, surface_attribs);
+}
+
+/* Surfaceless */
+
+static EGLDisplay
+surfaceless_open_display (gpointer *native)
+{
+    const gchar *extensions = eglQueryString (EGL_NO_DISPLAY,
+                                              EGL_EXTENSIONS);
+    GstGLESGetPlatformDisplay get_platform_display;
+
+    if (!extensions ||
+        !g_strstr_len (extensions, -1, "EGL_MESA_platform_surfaceless")) {
+        GST_ERROR ("EGL_MESA_platform_surfaceless is not available");
+        return EGL_NO_DISPLAY;
+    }
+
+    get_platform_display = (GstGLESGetPlatformDisplay)
+            eglGetProcAddress ("eglGetPlatformDisplayEXT");
+    if (!get_platform_display) {
+        GST_ERROR ("eglGetPlatformDisplayEXT is not available");
+        return EGL_NO_DISPLAY;
+    }
+
+    return get_platform_display (EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, NULL);
+}
+
+static const GstGLESBackend backends[GST_GLES_BACKEND_COUNT] = {
+    {
+        GST_GLES_BACKEND_X11, "x11", EGL_WINDOW_BIT, TRUE,
+        x11_open_display, x11_close_display,
+        x11_open, x11_create_surface, x11_handle_events, x11_close
+    },
+    {
+        GST_GLES_BACKEND_PBUFFER, "pbuffer", EGL_PBUFFER_BIT, FALSE,
+        pbuffer_open_display, NULL,
+        NULL, pbuffer_create_surface, NULL, NULL
+    },
+    {
+        /* contexts are made current without a surface */
+        GST_GLES_BACKEND_SURFACELESS, "surfaceless", 0, FALSE,
+        surfaceless_open_display, NULL,
+        NULL, NULL, NULL, NULL
+    }
+};
+
+const GstGLESBackend *
+gst_gles_backend_get (GstGLESBackendType type)
+{
+    g_return_val_if_fail (type < GST_GLES_BACKEND_COUNT, NULL);
+
+    return &backends[type];
+}
+
+/* Window */
+
+gint
+gst_gles_window_open (GstGLESWindow *window, gpointer native,
+                      const gchar *title, gint width, gint height)
+{
+    if (!window->external_window) {
+        window->width = width;
+        window->height = height;
+    }
+
+    if (window->backend->open)
+        return window->backend->open (window, native, title);
+
+    return 0;
+}
+
+void
+gst_gles_window_close (GstGLESWindow *window)
+{
+    if (window->backend && window->backend->close && window->display)
+        window->backend->close (window);
+    window->display = NULL;
+}
+
+EGLSurface
+gst_gles_window_create_surface (GstGLESWindow *window, EGLDisplay display,
+                                EGLConfig config)
+{
+    if (!window->backend->create_surface)
+        return EGL_NO_SURFACE;
+
+    return window->backend->create_surface (window, display, config);
+}
+
+void
+gst_gles_window_bind (GstGLESWindow *window)
+{
+    if (window->backend->create_surface) {
+        glBindFramebuffer (GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    /* without a surface an rgba texture stands in for the back buffer.
+     * Unit 3 is used, the onscreen pass binds its own texture there */
+    if (!window->framebuffer) {
+        glActiveTexture (GL_TEXTURE3);
+        glGenTextures (1, &window->texture);
+        glBindTexture (GL_TEXTURE_2D, window->texture);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, window->width,
+                      window->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        glGenFramebuffers (1, &window->framebuffer);
+        glBindFramebuffer (GL_FRAMEBUFFER, window->framebuffer);
+        glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                GL_TEXTURE_2D, window->texture, 0);
+        if (glCheckFramebufferStatus (GL_FRAMEBUFFER) !=
+            GL_FRAMEBUFFER_COMPLETE)
+            GST_ERROR ("Offscreen framebuffer is incomplete");
+        return;
+    }
+
+    glBindFramebuffer (GL_FRAMEBUFFER, window->framebuffer);
+}
+
+void
+gst_gles_window_release (GstGLESWindow *window)
+{
+    if (window->framebuffer) {
+        glDeleteFramebuffers (1, &window->framebuffer);
+        glDeleteTextures (1, &window->texture);
+    }
+    window->framebuffer = 0;
+    window->texture = 0;
+}
+
+void
+gst_gles_window_swap (GstGLESWindow *window, EGLDisplay display,
+                      EGLSurface surface)
+{
+    if (surface != EGL_NO_SURFACE)
+        eglSwapBuffers (display, surface);
+    else
+        glFlush ();
+}
+
+gboolean
+gst_gles_window_handle_events (GstGLESWindow *window)
+{
+    if (!window->backend->handle_events)
+        return FALSE;
+
+    return window->backend->handle_events (window);
+}
+
+void
+gst_gles_window_lock (GstGLESWindow *window)
+{
+    GstClockTime start;
+
+    if (!window->backend->needs_lock) {
+        window->lock_wait = 0;
+        return;
+    }
+
+    /* every instance on the display contends here */
+    start = gst_util_get_timestamp ();
+    XLockDisplay (window->display);
+    window->lock_wait = gst_util_get_timestamp () - start;
+}
+
+void
+gst_gles_window_unlock (GstGLESWindow *window)
+{
+    if (window->backend->needs_lock)
+        XUnlockDisplay (window->display);
+}
@@ -0,0 +1,116 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _WINDOW_H__
+#define _WINDOW_H__
+
+#include <GLES2/gl2.h>
+#include <EGL/egl.h>
+#include <X11/Xlib.h>
+#include <gst/gst.h>
+
+/* window systems the output can be drawn with */
+typedef enum
+{
+    GST_GLES_BACKEND_X11 = 0,
+    GST_GLES_BACKEND_PBUFFER,
+    GST_GLES_BACKEND_SURFACELESS,
+    GST_GLES_BACKEND_COUNT
+} GstGLESBackendType;
+
+#define GST_TYPE_GLES_BACKEND (gst_gles_backend_get_type ())
+
+typedef struct _GstGLESBackend     GstGLESBackend;
+typedef struct _GstGLESWindow      GstGLESWindow;
+
+struct _GstGLESWindow
+{
+    const GstGLESBackend *backend;
+
+    gint width;
+    gint height;
+
+    /* x11 context */
+    Display *display;
+    Window window;
+    gboolean external_window;
+
+    /* drawn to instead of the default framebuffer if the surface has
+     * none */
+    GLuint framebuffer;
+    GLuint texture;
+
+    /* how long the last gst_gles_window_lock waited for the display */
+    GstClockTime lock_wait;
+};
+
+/* what differs between the window systems. Headless backends leave the
+ * callbacks they do not need NULL */
+struct _GstGLESBackend
+{
+    GstGLESBackendType type;
+    const gchar *name;
+
+    /* config bits the surfaces need */
+    EGLint surface_type;
+    /* whether draws have to hold the lock of the native display */
+    gboolean needs_lock;
+
+    /* opens the native display and its EGL display */
+    EGLDisplay (*open_display) (gpointer *native);
+    void (*close_display) (gpointer native);
+
+    gint (*open) (GstGLESWindow *window, gpointer native,
+                  const gchar *title);
+    EGLSurface (*create_surface) (GstGLESWindow *window,
+                                  EGLDisplay display, EGLConfig config);
+    /* returns TRUE if the window was resized */
+    gboolean (*handle_events) (GstGLESWindow *window);
+    void (*close) (GstGLESWindow *window);
+};
+
+GType gst_gles_backend_get_type (void);
+const GstGLESBackend *gst_gles_backend_get (GstGLESBackendType type);
+
+/* creates the native window, the size is a hint */
+gint gst_gles_window_open (GstGLESWindow *window, gpointer native,
+                           const gchar *title, gint width, gint height);
+void gst_gles_window_close (GstGLESWindow *window);
+
+/* EGL_NO_SURFACE on failure, or for a backend without surfaces */
+EGLSurface gst_gles_window_create_surface (GstGLESWindow *window,
+                                           EGLDisplay display,
+                                           EGLConfig config);
+
+/* binds the framebuffer shown by the window, with its context current */
+void gst_gles_window_bind (GstGLESWindow *window);
+/* frees the gl objects of bind, with the context current */
+void gst_gles_window_release (GstGLESWindow *window);
+void gst_gles_window_swap (GstGLESWindow *window, EGLDisplay display,
+                           EGLSurface surface);
+
+gboolean gst_gles_window_handle_events (GstGLESWindow *window);
+
+/* serializes draws on a shared native display, free for the others */
+void gst_gles_window_lock (GstGLESWindow *window);
+void gst_gles_window_unlock (GstGLESWindow *window);
+
+#endif
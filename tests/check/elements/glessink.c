@@ -0,0 +1,682 @@
+/*
+ * GStreamer
+ * Copyright (C) 2011 Julian Scheel <julian@jusst.de>
+ * Copyright (C) 2011 Soeren Grunewald <soeren.grunewald@avionic-design.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Regression tests for glessink on a software GL, e.g. Mesa's llvmpipe.
+ *
+ * Known I420 patterns are rendered through the framebuffer and the
+ * onscreen pass into an offscreen surface the size of the video, so
+ * every output pixel maps to one input pixel. The sink reads every
+ * presented frame back (the readback property) and the pixels are
+ * compared against the colours the BT.601 conversion of the shaders
+ * gives for the input, within GST_GLES_CHECK_COLOR_TOLERANCE levels
+ * (default 2), for 8 bit I420 and the 10 bit layouts. Frames larger
+ * than a texture are split into a grid of them, the grid test lowers
+ * the limit with the max_texture_size property. I420 is uploaded as one
+ * packed texture, the planes test repeats the patterns with a texture
+ * per plane. The scaling test repeats the patterns with the bicubic
+ * and lanczos kernels, which have to reproduce a frame they do not
+ * scale.
+ *
+ * The throughput test renders 720p as fast as the sink can and prints
+ * the frame rate and the mean cpu cost of a frame. It fails if the
+ * rate drops more than GST_GLES_CHECK_TOLERANCE percent (default 20)
+ * below GST_GLES_CHECK_BASELINE_FPS, when a baseline is given.
+ *
+ * GST_GLES_CHECK_BACKEND selects the backend, surfaceless by default.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/video/video.h>
+
+#define PATTERN_WIDTH 320
+#define PATTERN_HEIGHT 240
+#define PATTERN_FRAMES 3
+
+/* pixels this close to an edge of the pattern are not compared, the
+ * chroma and the deinterlacer sample their neighbours there */
+#define PATTERN_MARGIN 4
+
+/* texture size the grid tests pretend to be the limit. The frame is
+ * split into 2x2 cells and converted scaled down, which blurs the edges
+ * of the pattern a little more */
+#define GRID_MAX_TEXTURE_SIZE 200
+#define GRID_MARGIN 8
+
+/* lanczos reads three pixels to either side */
+#define KERNEL_MARGIN 6
+
+#define THROUGHPUT_WIDTH 1280
+#define THROUGHPUT_HEIGHT 720
+#define THROUGHPUT_FRAMES 300
+
+#define DEFAULT_COLOR_TOLERANCE 2
+#define DEFAULT_TOLERANCE 20
+
+typedef struct
+{
+    guint8 y, u, v;
+} Yuv;
+
+/* white, yellow, cyan, green, magenta, red, blue and black bars */
+static const Yuv bars[] = {
+    { 235, 128, 128 },
+    { 210, 16, 146 },
+    { 170, 166, 16 },
+    { 145, 54, 34 },
+    { 106, 202, 222 },
+    { 81, 90, 240 },
+    { 41, 240, 110 },
+    { 16, 128, 128 }
+};
+
+static const gchar *
+check_backend (void)
+{
+    const gchar *backend = g_getenv ("GST_GLES_CHECK_BACKEND");
+    return backend ? backend : "surfaceless";
+}
+
+static gint
+check_env_int (const gchar *name, gint fallback)
+{
+    const gchar *value = g_getenv (name);
+    return value ? atoi (value) : fallback;
+}
+
+/* 10 bit formats carry the 8 bit values of the pattern shifted by 2 */
+static gboolean
+format_is_10bit (GstVideoFormat format)
+{
+    return format != GST_VIDEO_FORMAT_I420;
+}
+
+/* the conversion done by yuv_common.glsl */
+static void
+yuv_to_rgb (const Yuv *yuv, GstVideoFormat format, guint8 rgb[3])
+{
+    gdouble max = format_is_10bit (format) ? 1023.0 / 4.0 : 255.0;
+    gdouble y = 1.1643 * (yuv->y / max - 0.0625);
+    gdouble u = yuv->u / max - 0.5;
+    gdouble v = yuv->v / max - 0.5;
+    gdouble c[3];
+    guint i;
+
+    c[0] = y + 1.5958 * v;
+    c[1] = y - 0.39173 * u - 0.81290 * v;
+    c[2] = y + 2.017 * u;
+
+    for (i = 0; i < 3; i++)
+        rgb[i] = CLAMP (c[i], 0.0, 1.0) * 255.0 + 0.5;
+}
+
+/* returns the colour of a pixel of the pattern */
+typedef const Yuv * (*PatternFunc) (gint x, gint y, gint width, gint height);
+
+static const Yuv *
+pattern_bars (gint x, gint y, gint width, gint height)
+{
+    return &bars[x * G_N_ELEMENTS (bars) / width];
+}
+
+static const Yuv *
+pattern_split (gint x, gint y, gint width, gint height)
+{
+    return y < height / 2 ? &bars[5] : &bars[6];
+}
+
+static const Yuv *
+pattern_solid (gint x, gint y, gint width, gint height)
+{
+    return &bars[3];
+}
+
+/* true if the pixel is not within the margin of a colour change */
+static gboolean
+pattern_is_flat (PatternFunc pattern, gint x, gint y, gint width,
+                 gint height, gint margin)
+{
+    const Yuv *c = pattern (x, y, width, height);
+    gint dx, dy;
+
+    for (dy = -margin; dy <= margin; dy++) {
+        for (dx = -margin; dx <= margin; dx++) {
+            gint nx = CLAMP (x + dx, 0, width - 1);
+            gint ny = CLAMP (y + dy, 0, height - 1);
+
+            if (pattern (nx, ny, width, height) != c)
+                return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/* stores an 8 bit value of the pattern as sample of the format */
+static void
+pattern_store (GstVideoFormat format, guint8 *data, gint index, guint8 value)
+{
+    guint16 sample;
+
+    if (format == GST_VIDEO_FORMAT_I420) {
+        data[index] = value;
+        return;
+    }
+
+    sample = value << 2;
+    if (format == GST_VIDEO_FORMAT_P010_10LE)
+        sample <<= 6;
+    GST_WRITE_UINT16_LE (data + index * 2, sample);
+}
+
+static GstBuffer *
+pattern_frame (PatternFunc pattern, GstVideoInfo *info)
+{
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT (info);
+    GstVideoFrame frame;
+    GstBuffer *buf;
+    gint width = GST_VIDEO_INFO_WIDTH (info);
+    gint height = GST_VIDEO_INFO_HEIGHT (info);
+    gint x, y;
+
+    buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+    fail_unless (gst_video_frame_map (&frame, info, buf, GST_MAP_WRITE));
+
+    for (y = 0; y < height; y++) {
+        guint8 *row = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0) +
+                y * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+
+        for (x = 0; x < width; x++)
+            pattern_store (format, row, x, pattern (x, y, width, height)->y);
+    }
+
+    /* each chroma sample takes the colour of the top left luma pixel
+     * it covers */
+    for (y = 0; y < height / 2; y++) {
+        guint8 *u = GST_VIDEO_FRAME_PLANE_DATA (&frame, 1) +
+                y * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 1);
+        guint8 *v = NULL;
+
+        if (format != GST_VIDEO_FORMAT_P010_10LE)
+            v = GST_VIDEO_FRAME_PLANE_DATA (&frame, 2) +
+                    y * GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 2);
+
+        for (x = 0; x < width / 2; x++) {
+            const Yuv *c = pattern (x * 2, y * 2, width, height);
+
+            if (v) {
+                pattern_store (format, u, x, c->u);
+                pattern_store (format, v, x, c->v);
+            } else {
+                /* interleaved */
+                pattern_store (format, u, x * 2, c->u);
+                pattern_store (format, u, x * 2 + 1, c->v);
+            }
+        }
+    }
+
+    gst_video_frame_unmap (&frame);
+    return buf;
+}
+
+/* sink properties a pattern is rendered with */
+typedef struct
+{
+    gint max_texture_size;
+    const gchar *scaling;
+    gboolean packed_upload;
+} SinkConfig;
+
+static const SinkConfig default_config = { 0, "bilinear", TRUE };
+
+typedef struct
+{
+    GstElement *pipeline;
+    GstElement *src;
+    GstElement *sink;
+    GstVideoInfo info;
+} Pipeline;
+
+static void
+pipeline_setup (Pipeline *p, GstVideoFormat format, gint width, gint height)
+{
+    GstCaps *caps;
+
+    p->pipeline = gst_pipeline_new (NULL);
+    p->src = gst_element_factory_make ("appsrc", NULL);
+    p->sink = gst_element_factory_make ("glessink", NULL);
+    fail_unless (p->src != NULL && p->sink != NULL);
+
+    gst_video_info_set_format (&p->info, format, width, height);
+    GST_VIDEO_INFO_FPS_N (&p->info) = 25;
+    GST_VIDEO_INFO_FPS_D (&p->info) = 1;
+    caps = gst_video_info_to_caps (&p->info);
+
+    g_object_set (p->src, "caps", caps, "format", GST_FORMAT_TIME,
+                  "block", TRUE, "max-bytes",
+                  (guint64) GST_VIDEO_INFO_SIZE (&p->info), NULL);
+    gst_caps_unref (caps);
+
+    gst_util_set_object_arg (G_OBJECT (p->sink), "backend", check_backend ());
+    g_object_set (p->sink, "sync", FALSE, "window_width", width,
+                  "window_height", height, NULL);
+
+    gst_bin_add_many (GST_BIN (p->pipeline), p->src, p->sink, NULL);
+    fail_unless (gst_element_link (p->src, p->sink));
+}
+
+/* pushes the frame count times and ends the stream */
+static void
+pipeline_push (Pipeline *p, GstBuffer *frame, guint count)
+{
+    GstClockTime duration = gst_util_uint64_scale_int (GST_SECOND,
+            GST_VIDEO_INFO_FPS_D (&p->info), GST_VIDEO_INFO_FPS_N (&p->info));
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        GstBuffer *buf = gst_buffer_copy (frame);
+
+        GST_BUFFER_PTS (buf) = i * duration;
+        GST_BUFFER_DURATION (buf) = duration;
+        fail_unless_equals_int (gst_app_src_push_buffer (
+                GST_APP_SRC (p->src), buf), GST_FLOW_OK);
+    }
+
+    fail_unless_equals_int (gst_app_src_end_of_stream (GST_APP_SRC (p->src)),
+                            GST_FLOW_OK);
+}
+
+static void
+pipeline_teardown (Pipeline *p)
+{
+    fail_unless_equals_int (gst_element_set_state (p->pipeline,
+            GST_STATE_NULL), GST_STATE_CHANGE_SUCCESS);
+    gst_object_unref (p->pipeline);
+}
+
+/* renders the pattern and returns the last frame read back, colorimetry
+ * is NULL for the default of the format */
+static GstStructure *
+render_pattern (PatternFunc pattern, GstVideoFormat format,
+                const gchar *colorimetry, gboolean deinterlace,
+                const SinkConfig *config)
+{
+    Pipeline p;
+    GstStructure *readback = NULL;
+    GstBuffer *frame;
+    GstMessage *msg;
+    GstCaps *caps;
+    GstBus *bus;
+
+    pipeline_setup (&p, format, PATTERN_WIDTH, PATTERN_HEIGHT);
+    g_object_set (p.sink, "readback", TRUE, "deinterlace", deinterlace,
+                  "max_texture_size", config->max_texture_size,
+                  "packed_upload", config->packed_upload, NULL);
+    gst_util_set_object_arg (G_OBJECT (p.sink), "scaling", config->scaling);
+
+    if (colorimetry) {
+        fail_unless (gst_video_colorimetry_from_string (
+                &p.info.colorimetry, colorimetry));
+        caps = gst_video_info_to_caps (&p.info);
+        g_object_set (p.src, "caps", caps, NULL);
+        gst_caps_unref (caps);
+    }
+
+    bus = gst_element_get_bus (p.pipeline);
+    fail_unless (gst_element_set_state (p.pipeline, GST_STATE_PLAYING) !=
+                 GST_STATE_CHANGE_FAILURE);
+
+    frame = pattern_frame (pattern, &p.info);
+    pipeline_push (&p, frame, PATTERN_FRAMES);
+    gst_buffer_unref (frame);
+
+    while ((msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+            GST_MESSAGE_ELEMENT | GST_MESSAGE_EOS | GST_MESSAGE_ERROR))) {
+        const GstStructure *s = gst_message_get_structure (msg);
+
+        fail_if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR,
+                 "Pipeline error");
+        if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS) {
+            gst_message_unref (msg);
+            break;
+        }
+
+        if (gst_structure_has_name (s, "GstGLESSinkReadback")) {
+            if (readback)
+                gst_structure_free (readback);
+            readback = gst_structure_copy (s);
+        }
+        gst_message_unref (msg);
+    }
+
+    gst_object_unref (bus);
+    pipeline_teardown (&p);
+
+    fail_unless (readback != NULL, "No frame was read back");
+    return readback;
+}
+
+static void
+check_pattern_format (PatternFunc pattern, GstVideoFormat format,
+                      gboolean deinterlace, gint margin,
+                      const SinkConfig *config)
+{
+    gint tolerance = check_env_int ("GST_GLES_CHECK_COLOR_TOLERANCE",
+                                    DEFAULT_COLOR_TOLERANCE);
+    GstStructure *readback = render_pattern (pattern, format, NULL,
+                                             deinterlace, config);
+    const GValue *value;
+    GstMapInfo map;
+    GstBuffer *buf;
+    gint width, height;
+    gint worst = 0;
+    gint x, y;
+
+    fail_unless (gst_structure_get_int (readback, "width", &width));
+    fail_unless (gst_structure_get_int (readback, "height", &height));
+    fail_unless_equals_int (width, PATTERN_WIDTH);
+    fail_unless_equals_int (height, PATTERN_HEIGHT);
+
+    value = gst_structure_get_value (readback, "buffer");
+    buf = gst_value_get_buffer (value);
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, width * height * 4);
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            const guint8 *px = map.data + (y * width + x) * 4;
+            guint8 expected[3];
+            guint i;
+
+            if (!pattern_is_flat (pattern, x, y, width, height, margin))
+                continue;
+
+            yuv_to_rgb (pattern (x, y, width, height), format, expected);
+            for (i = 0; i < 3; i++) {
+                gint diff = ABS ((gint) px[i] - expected[i]);
+
+                fail_unless (diff <= tolerance, "Pixel %d,%d channel %u is "
+                             "%u, expected %u", x, y, i, px[i], expected[i]);
+                worst = MAX (worst, diff);
+            }
+        }
+    }
+
+    GST_INFO ("Largest colour difference %d", worst);
+
+    gst_buffer_unmap (buf, &map);
+    gst_structure_free (readback);
+}
+
+static void
+check_pattern (PatternFunc pattern, gboolean deinterlace, gint margin,
+               const SinkConfig *config)
+{
+    check_pattern_format (pattern, GST_VIDEO_FORMAT_I420, deinterlace,
+                          margin, config);
+}
+
+GST_START_TEST (test_solid)
+{
+    check_pattern (pattern_solid, FALSE, PATTERN_MARGIN, &default_config);
+    check_pattern (pattern_solid, TRUE, PATTERN_MARGIN, &default_config);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_bars)
+{
+    check_pattern (pattern_bars, FALSE, PATTERN_MARGIN, &default_config);
+    check_pattern (pattern_bars, TRUE, PATTERN_MARGIN, &default_config);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_split)
+{
+    check_pattern (pattern_split, FALSE, PATTERN_MARGIN, &default_config);
+    check_pattern (pattern_split, TRUE, PATTERN_MARGIN, &default_config);
+}
+GST_END_TEST;
+
+/* the bars cross the horizontal and the split the vertical edge between
+ * the cells, neither may show a seam */
+GST_START_TEST (test_grid)
+{
+    SinkConfig config = default_config;
+
+    config.max_texture_size = GRID_MAX_TEXTURE_SIZE;
+    check_pattern (pattern_bars, FALSE, GRID_MARGIN, &config);
+    check_pattern (pattern_bars, TRUE, GRID_MARGIN, &config);
+    check_pattern (pattern_split, FALSE, GRID_MARGIN, &config);
+    check_pattern (pattern_split, TRUE, GRID_MARGIN, &config);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_planes)
+{
+    SinkConfig config = default_config;
+
+    config.packed_upload = FALSE;
+    check_pattern (pattern_bars, FALSE, PATTERN_MARGIN, &config);
+    check_pattern (pattern_bars, TRUE, PATTERN_MARGIN, &config);
+    check_pattern (pattern_split, FALSE, PATTERN_MARGIN, &config);
+    check_pattern (pattern_split, TRUE, PATTERN_MARGIN, &config);
+}
+GST_END_TEST;
+
+GST_START_TEST (test_scaling)
+{
+    const gchar *kernels[] = { "bicubic", "lanczos" };
+    SinkConfig config = default_config;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (kernels); i++) {
+        config.scaling = kernels[i];
+        check_pattern (pattern_bars, FALSE, KERNEL_MARGIN, &config);
+        check_pattern (pattern_split, TRUE, KERNEL_MARGIN, &config);
+    }
+}
+GST_END_TEST;
+
+/* the deinterlacer samples the next line of a plane, which shows if the
+ * planes of a 10 bit layout are unpacked at the wrong offsets */
+GST_START_TEST (test_10bit)
+{
+    const GstVideoFormat formats[] = {
+        GST_VIDEO_FORMAT_I420_10LE,
+        GST_VIDEO_FORMAT_P010_10LE
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+        check_pattern_format (pattern_bars, formats[i], FALSE,
+                              PATTERN_MARGIN, &default_config);
+        check_pattern_format (pattern_bars, formats[i], TRUE,
+                              PATTERN_MARGIN, &default_config);
+        check_pattern_format (pattern_split, formats[i], TRUE,
+                              PATTERN_MARGIN, &default_config);
+    }
+}
+GST_END_TEST;
+
+#if GST_CHECK_VERSION(1, 18, 0)
+/* luma coding 1000 cd/m² in PQ, the default peak, on top of black */
+static const Yuv hdr_peak = { 181, 128, 128 };
+
+static const Yuv *
+pattern_hdr (gint x, gint y, gint width, gint height)
+{
+    return y < height / 2 ? &hdr_peak : &bars[7];
+}
+
+/* the peak has to end up at SDR white and black has to stay black */
+GST_START_TEST (test_hdr)
+{
+    gint tolerance = check_env_int ("GST_GLES_CHECK_COLOR_TOLERANCE",
+                                    DEFAULT_COLOR_TOLERANCE);
+    GstStructure *readback;
+    GstMapInfo map;
+    GstBuffer *buf;
+    const guint8 *top;
+    const guint8 *bottom;
+    guint i;
+
+    readback = render_pattern (pattern_hdr, GST_VIDEO_FORMAT_I420_10LE,
+                               "bt2100-pq", FALSE, &default_config);
+    buf = gst_value_get_buffer (gst_structure_get_value (readback,
+                                                         "buffer"));
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+
+    top = map.data + (PATTERN_HEIGHT / 4 * PATTERN_WIDTH +
+                      PATTERN_WIDTH / 2) * 4;
+    bottom = map.data + (PATTERN_HEIGHT * 3 / 4 * PATTERN_WIDTH +
+                         PATTERN_WIDTH / 2) * 4;
+    for (i = 0; i < 3; i++) {
+        fail_unless (top[i] >= 255 - tolerance, "Peak channel %u is %u",
+                     i, top[i]);
+        fail_unless (bottom[i] <= tolerance, "Black channel %u is %u",
+                     i, bottom[i]);
+    }
+
+    gst_buffer_unmap (buf, &map);
+    gst_structure_free (readback);
+}
+GST_END_TEST;
+#endif
+
+/* sums the cpu time of every render stage of a timings message */
+static GstClockTime
+timings_cost (const GstStructure *s)
+{
+    GstClockTime cost = 0;
+    gint i;
+
+    for (i = 0; i < gst_structure_n_fields (s); i++) {
+        const gchar *name = gst_structure_nth_field_name (s, i);
+        guint64 value;
+
+        if (g_str_has_suffix (name, "-cpu") &&
+            gst_structure_get_uint64 (s, name, &value) &&
+            GST_CLOCK_TIME_IS_VALID (value))
+            cost += value;
+    }
+
+    return cost;
+}
+
+GST_START_TEST (test_throughput)
+{
+    gint baseline = check_env_int ("GST_GLES_CHECK_BASELINE_FPS", 0);
+    gint tolerance = check_env_int ("GST_GLES_CHECK_TOLERANCE",
+                                    DEFAULT_TOLERANCE);
+    GstClockTime cost = 0;
+    GstClockTime start;
+    GstClockTime elapsed;
+    guint frames = 0;
+    gdouble fps;
+    Pipeline p;
+    GstBuffer *frame;
+    GstMessage *msg;
+    GstBus *bus;
+
+    pipeline_setup (&p, GST_VIDEO_FORMAT_I420, THROUGHPUT_WIDTH,
+                    THROUGHPUT_HEIGHT);
+    g_object_set (p.sink, "report_timings", TRUE, NULL);
+
+    bus = gst_element_get_bus (p.pipeline);
+    fail_unless (gst_element_set_state (p.pipeline, GST_STATE_PLAYING) !=
+                 GST_STATE_CHANGE_FAILURE);
+
+    frame = pattern_frame (pattern_bars, &p.info);
+    start = gst_util_get_timestamp ();
+    pipeline_push (&p, frame, THROUGHPUT_FRAMES);
+    gst_buffer_unref (frame);
+
+    while ((msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+            GST_MESSAGE_ELEMENT | GST_MESSAGE_EOS | GST_MESSAGE_ERROR))) {
+        const GstStructure *s = gst_message_get_structure (msg);
+
+        fail_if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR,
+                 "Pipeline error");
+        if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS) {
+            gst_message_unref (msg);
+            break;
+        }
+
+        if (gst_structure_has_name (s, "GstGLESSinkTimings")) {
+            cost += timings_cost (s);
+            frames++;
+        }
+        gst_message_unref (msg);
+    }
+    elapsed = gst_util_get_timestamp () - start;
+
+    gst_object_unref (bus);
+    pipeline_teardown (&p);
+
+    fail_unless (frames > 0, "No frame was rendered");
+    fps = frames * (gdouble) GST_SECOND / elapsed;
+    g_print ("glessink %dx%d: %.1f fps, %.3f ms cpu per frame\n",
+             THROUGHPUT_WIDTH, THROUGHPUT_HEIGHT, fps,
+             (gdouble) cost / frames / GST_MSECOND);
+
+    if (baseline > 0)
+        fail_unless (fps >= baseline * (100 - tolerance) / 100.0,
+                     "%.1f fps is more than %d%% below the baseline of %d",
+                     fps, tolerance, baseline);
+}
+GST_END_TEST;
+
+static Suite *
+glessink_suite (void)
+{
+    Suite *s = suite_create ("glessink");
+    TCase *tc_pixels = tcase_create ("pixels");
+    TCase *tc_perf = tcase_create ("performance");
+
+    suite_add_tcase (s, tc_pixels);
+    tcase_add_test (tc_pixels, test_solid);
+    tcase_add_test (tc_pixels, test_bars);
+    tcase_add_test (tc_pixels, test_split);
+    tcase_add_test (tc_pixels, test_grid);
+    tcase_add_test (tc_pixels, test_planes);
+    tcase_add_test (tc_pixels, test_scaling);
+    tcase_add_test (tc_pixels, test_10bit);
+#if GST_CHECK_VERSION(1, 18, 0)
+    tcase_add_test (tc_pixels, test_hdr);
+#endif
+
+    /* software rendering of a few hundred 720p frames takes a while */
+    suite_add_tcase (s, tc_perf);
+    tcase_set_timeout (tc_perf, 120);
+    tcase_add_test (tc_perf, test_throughput);
+
+    return s;
+}
+
+GST_CHECK_MAIN (glessink);